@@ -2,9 +2,11 @@
 #include "player.h"
 #include "Cell.h"
 #include "gamepage.h"
+#include "Profiler.h"
 #include <qgraphicsscene.h>
 #include <QFont>
-#include <QDebug>
+#include "GameRules.h"
+#include "Log.h"
 
 Agent::Agent(Player* owner, const QString& name, AgentType type,
              int hp, int mobility, int damage, int attackRange,
@@ -14,6 +16,8 @@ Agent::Agent(Player* owner, const QString& name, AgentType type,
     m_mobility(mobility), m_remainingMoves(mobility),
     m_damage(damage), m_attackRange(attackRange)
 {
+    TM_PROFILE_COUNT(ItemsCreated, 1);
+    
     // Set up the background rectangle with colored border
     setRect(-15, -15, 30, 30);
     
@@ -52,7 +56,7 @@ void Agent::setCell(Cell* cell)
 {
     // Validate placement if we're setting a new cell
     if (cell && !canBePlacedOn(cell->getType())) {
-        qDebug() << "Cannot place agent" << m_name << "on cell type" << cell->getType();
+        TM_LOG_DEBUG("Cannot place agent %1 on cell type %2", m_name, cell->getType());
         return;
     }
     
@@ -68,79 +72,52 @@ void Agent::setCell(Cell* cell)
 
 bool Agent::canMoveTo(Cell* target, GamePage* gamePage) const {
     if (!target || !isAlive() || !gamePage) {
-        qDebug() << "canMoveTo: Invalid parameters";
+        TM_LOG_DEBUG("canMoveTo: Invalid parameters");
         return false;
     }
 
     // Check if target is occupied
     if (target->isOccupied()) {
-        qDebug() << "canMoveTo: Target cell is occupied";
+        TM_LOG_DEBUG("canMoveTo: Target cell is occupied");
         return false;
     }
 
     // Check if agent can be placed on this cell type
     if (!canBePlacedOn(target->getType())) {
-        qDebug() << "canMoveTo: Agent" << m_name << "type" << m_type << "cannot be placed on cell type" << target->getType();
+        TM_LOG_DEBUG("canMoveTo: Agent %1 type %2 cannot be placed on cell type %3", m_name, m_type, target->getType());
         return false;
     }
 
-    // Use BFS to check if target is reachable within remaining moves
-    QList<Cell*> reachableCells = gamePage->getReachableCells(m_cell, m_remainingMoves, const_cast<Agent*>(this));
-    bool canReach = reachableCells.contains(target);
+    // Reachable within the remaining moves (see GameRules::moveCost)
+    const bool canReach = gamePage->moveCost(const_cast<Agent*>(this), target) >= 0;
     
-    qDebug() << "canMoveTo:" << m_name << "with" << m_remainingMoves << "moves can" << (canReach ? "reach" : "NOT reach") 
-             << "target at (" << target->getRow() << "," << target->getCol() << ")";
+    TM_LOG_DEBUG("canMoveTo: %1 with %2 moves can %3 target at (%4, %5)", m_name, m_remainingMoves,
+                 canReach ? "reach" : "NOT reach", target->getRow(), target->getCol());
     
     return canReach;
 }
 
 bool Agent::canBePlacedOn(Cell::CellType cellType) const {
-    // Check terrain restrictions based on agent type for PLACEMENT
-    switch(getType()) {
-    case WaterWalking:
-        // Can be placed on Water and Normal, but NOT on Rock
-        return cellType == Cell::Water || cellType == Cell::Normal || cellType == Cell::Goal;
-    case Grounded:
-        // Can be placed on Normal cells only
-        return cellType == Cell::Normal || cellType == Cell::Goal;
-    case Flying:
-        // Can be placed on Normal cells only (NOT on Water or Rock)
-        return cellType == Cell::Normal || cellType == Cell::Goal;
-    case Floating:
-        // Can be placed on all cell types
-        return true;
-    }
-    return false;
+    return GameRules::canPlaceOn(getType(), HexBoard::Terrain(cellType));
 }
 
 bool Agent::canMoveThrough(Cell::CellType cellType) const {
-    // Check terrain restrictions based on agent type for MOVEMENT
-    switch(getType()) {
-    case WaterWalking:
-        // Can move through Water and Normal, but NOT through Rock
-        return cellType == Cell::Water || cellType == Cell::Normal || cellType == Cell::Goal;
-    case Grounded:
-        // Can only move through Normal cells
-        return cellType == Cell::Normal || cellType == Cell::Goal;
-    case Flying:
-        // Can pass through any cells (including Rock and Water)
-        return true;
-    case Floating:
-        // Can move through all cell types
-        return true;
-    }
-    return false;
+    return GameRules::canMoveThrough(getType(), HexBoard::Terrain(cellType));
 }
 
-void Agent::moveTo(Cell* target, GamePage* gamePage) {
-    if (canMoveTo(target, gamePage)) {
-        // Calculate actual path distance using BFS
-        int distance = gamePage->getBFSDistance(m_cell, target, this);
-        if (distance > 0) {
-            m_remainingMoves -= distance;
-            setCell(target);
-        }
-    }
+bool Agent::moveTo(Cell* target, GamePage* gamePage) {
+    if (!target || !isAlive() || !gamePage) return false;
+
+    // One search decides the move: its cost comes off the remaining moves,
+    // its path is the animation
+    QList<Cell*> path;
+    const int cost = gamePage->moveCost(this, target, &path);
+    if (cost <= 0) return false;
+
+    m_remainingMoves -= cost;
+    setCell(target);
+    gamePage->animateAgent(this, path);
+    return true;
 }
 
 bool Agent::canAttack(Agent* target, GamePage* gamePage) const {
@@ -149,9 +126,10 @@ bool Agent::canAttack(Agent* target, GamePage* gamePage) const {
     // Can't attack own agents
     if (target->getOwner() == m_owner) return false;
 
-    // Use BFS to check if target is within attack range
-    QList<Cell*> cellsInRange = gamePage->getCellsInRange(m_cell, getAttackRange());
-    return cellsInRange.contains(target->getCell());
+    // With the line of sight rule on, Rock in between blocks ranged attacks
+    if (!gamePage->hasLineOfSight(m_cell, target->getCell())) return false;
+
+    return gamePage->isInRange(m_cell, target->getCell(), getAttackRange());
 }
 
 void Agent::attack(Agent* target, GamePage* gamePage) {
@@ -161,26 +139,17 @@ void Agent::attack(Agent* target, GamePage* gamePage) {
     target->takeDamage(getDamage());
     
     // 2. Attacker takes half of the damage he deals to himself
-    takeDamage(getDamage() / 2);
+    takeDamage(GameRules::counterDamage(getDamage()));
     
     // 3. Attacker will stand randomly in a valid cell around the opponent (target)
     if (isAlive()) {
-        QList<Cell*> adjacentToTarget = gamePage->getAdjacentCells(target->getCell());
-        QList<Cell*> available;
-        
-        for (Cell* cell : adjacentToTarget) {
-            if (!cell->isOccupied() && canBePlacedOn(cell->getType())) {
-                available.append(cell);
-            }
-        }
-
-        if (!available.isEmpty()) {
-            int randomIndex = rand() % available.size();
-            Cell* newPosition = available[randomIndex];
-            
+        // Seeded per match so lockstep peers pick the same cell
+        if (Cell* newPosition = gamePage->landingCell(this, target->getCell())) {
             // Move attacker to the random cell around the target
+            Cell* oldPosition = m_cell;
             m_cell->setAgent(nullptr); // Clear current cell
             setCell(newPosition);      // Move to new position
+            gamePage->animateAgent(this, {oldPosition, newPosition});
         }
     }
 }
@@ -200,37 +169,52 @@ void Agent::takeDamage(int amount) {
             m_cell = nullptr;
         }
         
-        // Remove from scene
+        // Remove from scene. The owning Player keeps the pointer (dead agents
+        // stay in its roster), so the agent is deleted by GamePage, not here.
         if (scene()) {
             scene()->removeItem(this);
         }
-        
-        // Schedule for deletion
-        deleteLater();
     }
 }
 
+void Agent::restoreState(int currentHP, int remainingMoves) {
+    const int previousHP = m_currentHP;
+    m_currentHP = qBound(0, currentHP, m_maxHP);
+    m_remainingMoves = remainingMoves;
+
+    // Moves aren't drawn; only a different HP touches the sprite
+    if (m_currentHP != previousHP) {
+        updateHealthBar();
+    }
+}
+
+void Agent::setShowDetails(bool show) {
+    m_nameText->setVisible(show);
+    m_healthBarBackground->setVisible(show);
+    m_healthBarForeground->setVisible(show);
+}
+
 void Agent::updateHealthBar() {
     if (!m_healthBarForeground) return;
     
-    // Calculate health percentage
-    float healthPercentage = (float)m_currentHP / (float)m_maxHP;
+    // Integer math only, so the display never depends on float rounding
+    const int maxHP = qMax(1, m_maxHP);
     
     // Update the width of the foreground bar
-    qreal newWidth = 30 * healthPercentage;
-    m_healthBarForeground->setRect(-15, -25, newWidth, 4);
+    m_healthBarForeground->setRect(-15, -25, 30 * m_currentHP / maxHP, 4);
     
-    // Change color based on health percentage
+    // Change color based on health percentage (above 60% / above 30%)
     QColor healthColor;
-    if (healthPercentage > 0.6f) {
+    if (m_currentHP * 10 > maxHP * 6) {
         healthColor = Qt::green;
-    } else if (healthPercentage > 0.3f) {
+    } else if (m_currentHP * 10 > maxHP * 3) {
         healthColor = Qt::yellow;
     } else {
         healthColor = Qt::red;
     }
     
     m_healthBarForeground->setBrush(QBrush(healthColor));
+    TM_PROFILE_COUNT(BrushChanges, 1);
 }
 
 void Agent::showPlacementZones(const QList<Cell*>& allCells) {
@@ -252,21 +236,7 @@ void Agent::hidePlacementZones(const QList<Cell*>& allCells) {
 
 bool Agent::canPlaceAgentType(AgentType type, Cell::CellType cellType) {
     // Static method to check placement rules without creating an agent instance
-    switch(type) {
-    case WaterWalking:
-        // Can be placed on Water and Normal, but NOT on Rock
-        return cellType == Cell::Water || cellType == Cell::Normal || cellType == Cell::Goal;
-    case Grounded:
-        // Can only be placed on Normal cells
-        return cellType == Cell::Normal || cellType == Cell::Goal;
-    case Flying:
-        // Can be placed on Normal cells only (NOT on Water or Rock)
-        return cellType == Cell::Normal || cellType == Cell::Goal;
-    case Floating:
-        // Can be placed on all cell types
-        return true;
-    }
-    return false;
+    return GameRules::canPlaceOn(type, HexBoard::Terrain(cellType));
 }
 
 void Agent::showPlacementZonesForType(AgentType type, const QList<Cell*>& allCells) {
@@ -291,3 +261,10 @@ QString Agent::getPlacementRules(AgentType type) {
     }
     return "Unknown agent type";
 }
+
+#ifdef TM_PROFILING
+void Agent::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    TM_PROFILE_COUNT(AgentsRepainted, 1);
+    QGraphicsRectItem::paint(painter, option, widget);
+}
+#endif
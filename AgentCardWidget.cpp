@@ -4,6 +4,7 @@
 #include <QVBoxLayout>
 #include <QMouseEvent>
 #include <QFont>
+#include "AssetLoader.h"
 
 AgentCardWidget::AgentCardWidget(const QString& name, AgentType type,
                                  int hp, int mobility, int damage, int attackRange,
@@ -22,7 +23,10 @@ AgentCardWidget::AgentCardWidget(const QString& name, AgentType type,
     iconLabel = new QLabel(this);
     iconLabel->setFixedSize(50, 50);
     iconLabel->setAlignment(Qt::AlignCenter);
-    iconLabel->setPixmap(QPixmap(getImagePathForType(type)).scaled(50, 50, Qt::KeepAspectRatio));
+    // Normally already 50x50 (see assets.txt)
+    QPixmap icon(AssetLoader::scaledPath(getImagePathForType(type), QSize(50, 50)));
+    if (icon.width() > 50 || icon.height() > 50) icon = icon.scaled(50, 50, Qt::KeepAspectRatio);
+    iconLabel->setPixmap(icon);
 
     // Stats (right side)
     QVBoxLayout* statsLayout = new QVBoxLayout();
@@ -0,0 +1,39 @@
+// AgentRoster.cpp - Implementation of AgentRoster
+#include "AgentRoster.h"
+
+const QVector<AgentDef>& AgentRoster::all() {
+    static const QVector<AgentDef> agents = {
+        {"Sir Lamorak", Grounded, 320, 3, 110, 1},
+        {"Kabul", Grounded, 400, 2, 120, 1},
+        {"Rajakal", Grounded, 320, 2, 130, 1},
+        {"Salih", Grounded, 400, 2, 80, 1},
+        {"Khan", Grounded, 320, 2, 90, 1},
+        {"Boi", Grounded, 400, 2, 100, 1},
+        {"Eloi", Grounded, 240, 2, 100, 2},
+        {"Kanar", Grounded, 160, 2, 100, 2},
+        {"Elsa", Grounded, 320, 2, 140, 2},
+        {"Karissa", Grounded, 280, 2, 80, 2},
+        {"Sir Philip", Grounded, 400, 2, 100, 1},
+        {"Frost", Grounded, 260, 2, 80, 2},
+        {"Tusk", Grounded, 400, 2, 100, 1},
+        {"Rambu", Flying, 320, 3, 120, 1},
+        {"Sabrina", Floating, 320, 3, 100, 1},
+        {"Death", Floating, 240, 3, 120, 2},
+        {"Reketon", WaterWalking, 320, 2, 80, 2},
+        {"Angus", WaterWalking, 400, 2, 100, 1},
+        {"Duraham", WaterWalking, 320, 2, 100, 2},
+        {"Colonel Baba", WaterWalking, 400, 2, 100, 1},
+        {"Medusa", WaterWalking, 320, 2, 90, 2},
+        {"Bunka", WaterWalking, 320, 3, 100, 1},
+        {"Sanka", WaterWalking, 320, 3, 100, 1},
+        {"Billy", WaterWalking, 320, 3, 90, 1}
+    };
+    return agents;
+}
+
+const AgentDef* AgentRoster::find(const QString& name) {
+    for (const AgentDef& agent : all()) {
+        if (agent.name == name) return &agent;
+    }
+    return nullptr;
+}
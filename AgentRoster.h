@@ -0,0 +1,22 @@
+// AgentRoster.h - The fixed list of agents players can pick from
+#ifndef AGENTROSTER_H
+#define AGENTROSTER_H
+
+#include <QString>
+#include <QVector>
+#include "AgentType.h"
+
+struct AgentDef {
+    QString name;
+    AgentType type;
+    int hp, mobility, damage, attackRange;
+};
+
+class AgentRoster {
+public:
+    // Immutable and built once, so it is safe to share between threads
+    static const QVector<AgentDef>& all();
+    static const AgentDef* find(const QString& name);
+};
+
+#endif // AGENTROSTER_H
@@ -0,0 +1,67 @@
+// AssetLoader.cpp - Implementation of AssetLoader
+#include "AssetLoader.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QLabel>
+#include <QPixmapCache>
+#include <QPointer>
+#include <QThreadPool>
+#include "Log.h"
+#include "TraceRecorder.h"
+
+namespace {
+
+const QString ResourceDir = ":/new/prefix1/";
+
+// assets.index, one "<name> <w>x<h> <file>" line per scaled picture
+QHash<QString, QString> loadIndex() {
+    QHash<QString, QString> index;
+    QFile file(ResourceDir + "assets.index");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        TM_LOG_WARNING("No asset index, pictures are scaled at run time");
+        return index;
+    }
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    for (const QString& line : lines) {
+        const QStringList fields = line.split(' ');
+        if (fields.size() == 3) index.insert(ResourceDir + fields[0] + ' ' + fields[1], ResourceDir + fields[2]);
+    }
+    return index;
+}
+
+}
+
+QString AssetLoader::scaledPath(const QString& path, const QSize& size) {
+    static const QHash<QString, QString> index = loadIndex();
+    return index.value(QString("%1 %2x%3").arg(path).arg(size.width()).arg(size.height()), path);
+}
+
+void AssetLoader::loadPixmap(QLabel* label, const QString& path) {
+    QPixmap cached;
+    if (QPixmapCache::find(path, &cached)) {
+        label->setPixmap(cached);
+        return;
+    }
+
+    QPointer<QLabel> target(label);
+    QThreadPool::globalInstance()->start([target, path]() {
+        TM_TRACE_SPAN("decode image", "startup");
+        const QImage image(path);
+        if (image.isNull()) {
+            TM_LOG_WARNING("Cannot decode image %1", path);
+            return;
+        }
+
+        // QPixmap belongs to the GUI thread
+        QMetaObject::invokeMethod(qApp, [target, path, image]() {
+            QPixmap pixmap;
+            if (!QPixmapCache::find(path, &pixmap)) {
+                pixmap = QPixmap::fromImage(image);
+                QPixmapCache::insert(path, pixmap);
+            }
+            if (target) target->setPixmap(pixmap);
+        }, Qt::QueuedConnection);
+    });
+}
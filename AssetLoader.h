@@ -0,0 +1,26 @@
+// AssetLoader.h - Decodes images off the GUI thread
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <QSize>
+#include <QString>
+
+class QLabel;
+
+// Pages set their pictures when first shown instead of in setupUi(), and
+// the JPEG decoding happens on a pool thread; only the (cheap) conversion to
+// a QPixmap is left for the GUI thread. Decoded pictures go into
+// QPixmapCache by path, so the backgrounds shared by several pages are
+// decoded once.
+class AssetLoader {
+public:
+    // Sets the picture at path on label once decoded, unless the label has
+    // been deleted by then; at once if it is already cached
+    static void loadPixmap(QLabel* label, const QString& path);
+
+    // The copy of a picture the build scaled to size (see assets.txt), or
+    // path itself if there is none
+    static QString scaledPath(const QString& path, const QSize& size);
+};
+
+#endif // ASSETLOADER_H
@@ -0,0 +1,316 @@
+// BoardBenchmark.cpp - Microbenchmarks for GamePage board queries
+//
+//   tm_bench                          human readable
+//   tm_bench -o bench.xml,xml         machine readable (also csv, junitxml)
+//   tm_bench loadMap:gen-100000       one function, one map
+//
+// Every query benchmark runs the same fixed batch of queries per iteration
+// (see SampleCount), so results are comparable across map sizes. Maps are
+// the eight bundled grids plus generated maps of 100 to 100,000 hexes
+// (see MapGenerator.h).
+#include <QApplication>
+#include <QComboBox>
+#include <QGraphicsView>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "AgentRoster.h"
+#include "DistanceField.h"
+#include "HexBoard.h"
+#include "MapGenerator.h"
+#include "MapValidator.h"
+#include "MatchState.h"
+#include "gamepage.h"
+#include "player.h"
+
+namespace {
+
+const int SampleCount = 256;        // Queries per iteration
+const int DistanceSampleCount = 32; // getBFSDistance is unbounded, so fewer pairs
+const int GeneratedSizes[] = {100, 1000, 10000, 100000};
+
+QString generateMapText(int targetCells, quint32 seed) {
+    MapGenerator::Options options;
+    options.targetCells = targetCells;
+    options.seed = seed;
+    return MapGenerator(options).toText();
+}
+
+}
+
+class BoardBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void getCellAt_data() { addMapRows(); }
+    void getCellAt();
+    void getAdjacentCells_data() { addMapRows(); }
+    void getAdjacentCells();
+    void getReachableCells_data() { addMapRows(); }
+    void getReachableCells();
+    void getCellsInRange_data() { addMapRows(); }
+    void getCellsInRange();
+    void getBFSDistance_data() { addMapRows(); }
+    void getBFSDistance();
+    void distanceField_data() { addMapRows(); }
+    void distanceField();
+    void validateMap_data() { addMapRows(); }
+    void validateMap();
+    void loadMap_data() { addMapRows(); }
+    void loadMap();
+    void clickCycle_data() { addMapRows(); }
+    void clickCycle();
+    void generateMap_data();
+    void generateMap();
+
+private:
+    void addMapRows();
+    void loadRow();
+    QList<Cell*> sampleCells(int count) const;
+
+    QTemporaryDir m_mapDir;
+    QComboBox* m_mapSelector = nullptr;
+    QGraphicsView* m_view = nullptr;
+    Player* m_player1 = nullptr;
+    Player* m_player2 = nullptr;
+    GamePage* m_page = nullptr;
+};
+
+void BoardBenchmark::initTestCase() {
+    QVERIFY(m_mapDir.isValid());
+    for (int size : GeneratedSizes) {
+        QFile file(m_mapDir.filePath(QString("gen-%1.txt").arg(size)));
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        file.write(generateMapText(size, quint32(size)).toUtf8());
+    }
+
+    m_mapSelector = new QComboBox();
+    m_view = new QGraphicsView();
+    m_player1 = new Player("Bench 1", true);
+    m_player2 = new Player("Bench 2", false);
+    m_page = new GamePage(m_mapSelector, m_view, m_player1, m_player2);
+    m_page->setAnimatedMoves(false);   // No event loop runs between clicks anyway
+}
+
+void BoardBenchmark::cleanupTestCase() {
+    delete m_page;
+    delete m_player1;
+    delete m_player2;
+    delete m_view;
+    delete m_mapSelector;
+}
+
+void BoardBenchmark::addMapRows() {
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<QString>("mapName");
+
+    for (int i = 1; i <= 8; ++i) {
+        const QString name = QString("grid%1.txt").arg(i);
+        QTest::newRow(qPrintable(name)) << (":/new/prefix1/" + name) << name;
+    }
+    for (int size : GeneratedSizes) {
+        const QString name = QString("gen-%1").arg(size);
+        QTest::newRow(qPrintable(name)) << m_mapDir.filePath(name + ".txt") << name;
+    }
+}
+
+void BoardBenchmark::loadRow() {
+    QFETCH(QString, path);
+    QFETCH(QString, mapName);
+    m_page->loadMap(path, mapName);
+    QVERIFY(!m_page->getCells().isEmpty());
+}
+
+QList<Cell*> BoardBenchmark::sampleCells(int count) const {
+    // Spread evenly over the board, so small maps repeat cells
+    const QVector<Cell*>& cells = m_page->getCells();
+    QList<Cell*> samples;
+    for (int i = 0; i < count; ++i) {
+        samples.append(cells[int(qint64(i) * 7919 % cells.size())]);
+    }
+    return samples;
+}
+
+void BoardBenchmark::getCellAt() {
+    loadRow();
+    const QList<Cell*> samples = sampleCells(SampleCount);
+
+    int found = 0;
+    QBENCHMARK {
+        for (Cell* cell : samples) {
+            found += m_page->getCellAt(cell->getRow(), cell->getCol()) != nullptr;
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void BoardBenchmark::getAdjacentCells() {
+    loadRow();
+    const QList<Cell*> samples = sampleCells(SampleCount);
+
+    qsizetype total = 0;
+    QBENCHMARK {
+        for (Cell* cell : samples) {
+            total += m_page->getAdjacentCells(cell).size();
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+void BoardBenchmark::getReachableCells() {
+    loadRow();
+    const QList<Cell*> samples = sampleCells(SampleCount);
+
+    qsizetype total = 0;
+    QBENCHMARK {
+        for (Cell* cell : samples) {
+            total += m_page->getReachableCells(cell, 3).size();
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+void BoardBenchmark::getCellsInRange() {
+    loadRow();
+    const QList<Cell*> samples = sampleCells(SampleCount);
+
+    qsizetype total = 0;
+    QBENCHMARK {
+        for (Cell* cell : samples) {
+            total += m_page->getCellsInRange(cell, 2).size();
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+void BoardBenchmark::getBFSDistance() {
+    loadRow();
+    const QList<Cell*> samples = sampleCells(DistanceSampleCount * 2);
+
+    qint64 total = 0;
+    QBENCHMARK {
+        for (int i = 0; i < DistanceSampleCount; ++i) {
+            total += m_page->getBFSDistance(samples[i], samples[i + DistanceSampleCount]);
+        }
+    }
+    QVERIFY(total != 0);
+}
+
+void BoardBenchmark::distanceField() {
+    QFETCH(QString, path);
+    QFETCH(QString, mapName);
+
+    // Distances to player 2's whole placement zone, for every cell and type
+    QSharedPointer<const HexBoard> board = HexBoard::fromFile(path, mapName);
+    MatchState state(board);
+    DistanceField field;
+    QBENCHMARK {
+        state.distancesTo(board->placementZone(1), field);
+    }
+    QCOMPARE(field.cellCount(), board->cellCount());
+}
+
+void BoardBenchmark::validateMap() {
+    QFETCH(QString, path);
+    QFETCH(QString, mapName);
+
+    QSharedPointer<const HexBoard> board = HexBoard::fromFile(path, mapName);
+    MapValidator validator;
+    MapValidator::Report report;
+    QBENCHMARK {
+        report = validator.check(*board);
+    }
+    QVERIFY(report.types[Flying].passableCells > 0);
+}
+
+void BoardBenchmark::loadMap() {
+    QFETCH(QString, path);
+    QFETCH(QString, mapName);
+
+    QBENCHMARK {
+        m_page->loadMap(path, mapName);
+    }
+    QVERIFY(!m_page->getCells().isEmpty());
+}
+
+void BoardBenchmark::clickCycle() {
+    QFETCH(QString, path);
+    QFETCH(QString, mapName);
+    m_page->loadMap(path, mapName);
+
+    // One Floating agent per side (it may stand anywhere), on the first zone
+    // cell that has a free neighbour to step to and back from
+    QSharedPointer<const HexBoard> board = HexBoard::fromFile(path, mapName);
+    MatchState state(board);
+    int home[2] = {-1, -1};
+    int away[2] = {-1, -1};
+    for (int player = 0; player < 2; ++player) {
+        AgentDef def{QString("Bench%1").arg(player + 1), Floating, 1000, 3, 1, 1};
+        for (int cell : state.validPlacementCells(player)) {
+            const int* neighbor = board->neighborsBegin(cell);
+            for (; neighbor != board->neighborsEnd(cell); ++neighbor) {
+                if (state.agentAt(*neighbor) < 0 && *neighbor != home[0] && *neighbor != away[0]) break;
+            }
+            if (neighbor != board->neighborsEnd(cell) && state.placeAgent(player, def, cell)) {
+                home[player] = cell;
+                away[player] = *neighbor;
+                break;
+            }
+        }
+        QVERIFY2(home[player] >= 0, "map has no usable placement cell");
+    }
+    state.startBattle();
+    QVERIFY(m_page->restoreSnapshot(state.toSnapshot()));
+
+    // Each iteration: both sides step out and back again, four select +
+    // highlight + move + clear cycles that leave the board as it was
+    const QVector<Cell*>& cells = m_page->getCells();
+    QBENCHMARK {
+        m_page->onCellInteraction(cells[home[0]]);
+        m_page->onCellInteraction(cells[away[0]]);
+        m_page->onCellInteraction(cells[home[1]]);
+        m_page->onCellInteraction(cells[away[1]]);
+        m_page->onCellInteraction(cells[away[0]]);
+        m_page->onCellInteraction(cells[home[0]]);
+        m_page->onCellInteraction(cells[away[1]]);
+        m_page->onCellInteraction(cells[home[1]]);
+    }
+    QCOMPARE(cells[home[0]]->getAgent() != nullptr, true);
+    QCOMPARE(cells[home[1]]->getAgent() != nullptr, true);
+}
+
+void BoardBenchmark::generateMap_data() {
+    QTest::addColumn<int>("size");
+    for (int size : GeneratedSizes) {
+        QTest::newRow(qPrintable(QString("gen-%1").arg(size))) << size;
+    }
+}
+
+void BoardBenchmark::generateMap() {
+    QFETCH(int, size);
+    MapGenerator::Options options;
+    options.targetCells = size;
+    options.seed = quint32(size);
+    options.goalCount = 2;
+
+    int cells = 0;
+    QBENCHMARK {
+        cells = MapGenerator(options).cells().size();
+    }
+    QVERIFY(cells >= size);
+}
+
+int main(int argc, char *argv[])
+{
+    // No window is ever shown; don't require a display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    BoardBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "BoardBenchmark.moc"
@@ -0,0 +1,94 @@
+// BoardNavigator.cpp - Implementation of BoardNavigator
+#include "BoardNavigator.h"
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QtMath>
+#include "Cell.h"
+#include "HexBoard.h"
+
+BoardNavigator::BoardNavigator(QGraphicsView* view, QObject* parent)
+    : QObject(parent), m_view(view)
+{
+    // zoomBy() anchors itself; cell bounds already leave room for
+    // antialiased outlines, so the view needn't pad every exposed rect
+    m_view->setTransformationAnchor(QGraphicsView::NoAnchor);
+    m_view->setOptimizationFlag(QGraphicsView::DontAdjustForAntialiasing);
+    m_view->viewport()->setMouseTracking(true);   // For hovered()
+    m_view->viewport()->installEventFilter(this);
+}
+
+void BoardNavigator::setBoard(const HexBoard* board) {
+    m_board = board;
+    m_hoveredIndex = -1;
+}
+
+int BoardNavigator::cellIndexAt(const QPoint& viewportPos) const {
+    return m_board ? Cell::hexAt(m_view->mapToScene(viewportPos), *m_board) : -1;
+}
+
+void BoardNavigator::zoomBy(double factor, const QPoint& anchor) {
+    const double current = scale();
+    const double target = qBound(MinScale, current * factor, MaxScale);
+    if (qFuzzyCompare(target, current)) return;
+
+    const bool detailBefore = showsDetail();
+    const QPointF anchorInScene = m_view->mapToScene(anchor);
+    m_view->scale(target / current, target / current);
+
+    const QPoint moved = m_view->mapFromScene(anchorInScene) - anchor;
+    m_view->horizontalScrollBar()->setValue(m_view->horizontalScrollBar()->value() + moved.x());
+    m_view->verticalScrollBar()->setValue(m_view->verticalScrollBar()->value() + moved.y());
+
+    if (showsDetail() != detailBefore) emit detailChanged(showsDetail());
+}
+
+bool BoardNavigator::eventFilter(QObject* watched, QEvent* event) {
+    Q_UNUSED(watched);
+    switch (event->type()) {
+    case QEvent::Wheel: {
+        QWheelEvent* wheel = static_cast<QWheelEvent*>(event);
+        // One notch (120) zooms by about a fifth
+        zoomBy(qPow(1.0015, wheel->angleDelta().y()), wheel->position().toPoint());
+        return true;
+    }
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick: {   // The second press of a double click
+        QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+        if (mouse->button() != Qt::MiddleButton) {
+            emit cellClicked(cellIndexAt(mouse->position().toPoint()));
+            return true;
+        }
+        m_panning = true;
+        m_lastPanPos = mouse->position().toPoint();
+        m_view->viewport()->setCursor(Qt::ClosedHandCursor);
+        return true;
+    }
+    case QEvent::MouseMove: {
+        QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+        if (!m_panning) {
+            if (mouse->buttons() != Qt::NoButton) return false;
+            const int index = cellIndexAt(mouse->position().toPoint());
+            if (index != m_hoveredIndex) {
+                m_hoveredIndex = index;
+                emit cellHovered(index);
+            }
+            return false;
+        }
+        const QPoint delta = mouse->position().toPoint() - m_lastPanPos;
+        m_lastPanPos = mouse->position().toPoint();
+        m_view->horizontalScrollBar()->setValue(m_view->horizontalScrollBar()->value() - delta.x());
+        m_view->verticalScrollBar()->setValue(m_view->verticalScrollBar()->value() - delta.y());
+        return true;
+    }
+    case QEvent::MouseButtonRelease: {
+        QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+        if (!m_panning || mouse->button() != Qt::MiddleButton) return false;
+        m_panning = false;
+        m_view->viewport()->unsetCursor();
+        return true;
+    }
+    default:
+        return false;
+    }
+}
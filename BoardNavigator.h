@@ -0,0 +1,58 @@
+// BoardNavigator.h - Zoom and pan for the game view, and its level of detail
+#ifndef BOARDNAVIGATOR_H
+#define BOARDNAVIGATOR_H
+
+#include <QGraphicsView>
+#include <QObject>
+#include <QPoint>
+
+class HexBoard;
+
+// Watches the game view's viewport: the wheel zooms about the cursor, the
+// middle button drags the board. It is also the board's one input
+// dispatcher: left and right clicks, and the cell under a mouse moving with
+// no button down, come out as cell indices (see Cell::hexAt), so the scene
+// never hit-tests them and cells need no signals of their own.
+//
+// Below DetailScale the board is drawn for overview: cells are solid tiles
+// without outlines (see Cell::paint) and agents drop their labels and health
+// bars. The view only ever draws the items whose bounds meet the exposed
+// rect, and cell bounds are fixed hex rects (see Cell::boundingRect), so a
+// pan of a huge board costs what is on screen, not the board's size.
+class BoardNavigator : public QObject {
+    Q_OBJECT
+public:
+    static constexpr double MinScale = 0.05;
+    static constexpr double MaxScale = 4.0;
+    static constexpr double DetailScale = 0.5;   // A hex about 30 pixels across
+
+    explicit BoardNavigator(QGraphicsView* view, QObject* parent = nullptr);
+
+    // The board whose indices clicks map to; null while none is loaded
+    void setBoard(const HexBoard* board);
+
+    double scale() const { return m_view->transform().m11(); }
+    bool showsDetail() const { return scale() >= DetailScale; }
+
+    // Keeps the scene point under anchor (viewport pixels) where it is
+    void zoomBy(double factor, const QPoint& anchor);
+
+signals:
+    void detailChanged(bool showsDetail);
+    void cellClicked(int index);   // -1 between hexes and off the board
+    void cellHovered(int index);   // When the cell under the mouse changes, -1 for none
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    int cellIndexAt(const QPoint& viewportPos) const;
+
+    QGraphicsView* m_view;
+    const HexBoard* m_board = nullptr;
+    int m_hoveredIndex = -1;
+    bool m_panning = false;
+    QPoint m_lastPanPos;
+};
+
+#endif // BOARDNAVIGATOR_H
@@ -4,20 +4,59 @@
 #include <QtMath>
 #include <QDebug>
 #include <QGraphicsSceneMouseEvent>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
 #include "agent.h"
+#include "BoardNavigator.h"
+#include "HexBoard.h"
+#include "Profiler.h"
 
 Cell::Cell(int row, int col, CellType type, QGraphicsItem* parent)
     : QGraphicsPolygonItem(parent), m_row(row), m_col(col), m_type(type)
 {
+    TM_PROFILE_COUNT(ItemsCreated, 1);
     createHexagon();
 }
 
-void Cell::createHexagon() {
+QPointF Cell::centerAt(int row, int col) {
     const double w = m_size * 2;
     const double h = qSqrt(3) * m_size;
-    double x = m_col * (0.65 * w);
-    double y = m_row * h + (m_col % 2);
-    m_center = QPointF(x, y);
+    double x = col * (0.65 * w);
+    double y = row * h + (col % 2);
+    return QPointF(x, y);
+}
+
+int Cell::hexAt(const QPointF& scenePos, const HexBoard& board) {
+    // A hex reaches cos(30) * size to either side and size up and down, so
+    // at most two columns and two rows can hold one that covers the point.
+    // Only every other row/col pair is a cell on a map, and the hexes of the
+    // pairs in between would overlap the real ones, so a hex that covers the
+    // point but isn't on the board doesn't count.
+    const double columnWidth = 0.65 * m_size * 2;
+    const double rowHeight = qSqrt(3) * m_size;
+    const double halfWidth = 0.8660254 * m_size;
+    const int firstCol = qMax(0, qCeil((scenePos.x() - halfWidth) / columnWidth));
+    const int lastCol = qFloor((scenePos.x() + halfWidth) / columnWidth);
+    const int firstRow = qMax(0, qCeil((scenePos.y() - m_size - 1) / rowHeight));
+    const int lastRow = qFloor((scenePos.y() + m_size) / rowHeight);
+
+    for (int r = firstRow; r <= lastRow; ++r) {
+        for (int c = firstCol; c <= lastCol; ++c) {
+            const QPointF offset = scenePos - centerAt(r, c);
+            const double dx = qAbs(offset.x());
+            const double dy = qAbs(offset.y());
+            // Pointy-top hex: straight sides, then edges sloping to the tips
+            if (dx <= halfWidth && dy <= m_size - dx / qSqrt(3)) {
+                const int index = board.indexAt(r, c);
+                if (index >= 0) return index;
+            }
+        }
+    }
+    return -1;
+}
+
+void Cell::createHexagon() {
+    m_center = centerAt(m_row, m_col);
 
     QPolygonF hex;
     for (int i = 0; i < 6; ++i) {
@@ -29,14 +68,7 @@ void Cell::createHexagon() {
     setPolygon(hex);
 
     // Set brush based on type
-    QBrush brush(Qt::white);
-    if (m_type == Water) {
-        brush = Qt::blue;
-    } else if (m_type == Rock) {
-        brush = Qt::darkGray;
-    } else if (m_type == Goal) {
-        brush = Qt::yellow;
-    }
+    const QBrush brush = terrainBrush(m_type);
     setBrush(brush);
     setPen(QPen(Qt::gray));
     setFlag(QGraphicsItem::ItemIsSelectable);
@@ -53,6 +85,9 @@ bool Cell::isOccupied() const { return m_agent != nullptr; }
 Agent* Cell::getAgent() const { return m_agent; }
 int Cell::getRow() const { return m_row; }
 int Cell::getCol() const { return m_col; }
+int Cell::getIndex() const { return m_index; }
+
+void Cell::setIndex(int index) { m_index = index; }
 
 void Cell::setAgent(Agent* agent) {
     m_agent = agent;
@@ -82,15 +117,19 @@ QList<Cell*> Cell::getAdjacentCells() const {
     return adjacent;
 }
 
-void Cell::resetBrush() {
-    QBrush brush;
-    switch(m_type) {
-    case Water: brush = Qt::blue; break;
-    case Rock: brush = Qt::darkGray; break;
-    case Goal: brush = Qt::yellow; break;
-    default: brush = Qt::white;
+QBrush Cell::terrainBrush(CellType type) {
+    switch(type) {
+    case Water: return QBrush(Qt::blue);
+    case Rock: return QBrush(Qt::darkGray);
+    case Goal: return QBrush(Qt::yellow);
+    default: return QBrush(Qt::white);
     }
+}
+
+void Cell::resetBrush() {
+    const QBrush brush = terrainBrush(m_type);
     setBrush(brush);
+    TM_PROFILE_COUNT(BrushChanges, 1);
     m_originalBrush = brush; // Update stored original brush
 }
 
@@ -108,6 +147,7 @@ void Cell::highlightForPlacement(bool canPlace) {
     if (m_isHighlighted) return; // Already highlighted
     
     m_isHighlighted = true;
+    TM_PROFILE_COUNT(BrushChanges, 1);
     
     if (canPlace) {
         // Green highlight for valid placement
@@ -124,6 +164,7 @@ void Cell::clearHighlight() {
     if (!m_isHighlighted) return; // Not highlighted
     
     m_isHighlighted = false;
+    TM_PROFILE_COUNT(BrushChanges, 1);
     setBrush(m_originalBrush);
     setPen(m_originalPen);
 }
@@ -136,7 +177,44 @@ void Cell::setPlacementHint(bool canPlace) {
     }
 }
 
-void Cell::mousePressEvent(QGraphicsSceneMouseEvent* event) {
-    QGraphicsPolygonItem::mousePressEvent(event);
-    emit clicked(this);
+QRectF Cell::boundingRect() const {
+    // Corners at 30 + 60i degrees: cos(30) * size to the sides, size up and
+    // down; 2 more for the 3 pixel highlight pen and antialiasing
+    const double halfWidth = 0.8660254 * m_size + 2;
+    const double halfHeight = m_size + 2;
+    return QRectF(m_center.x() - halfWidth, m_center.y() - halfHeight, 2 * halfWidth, 2 * halfHeight);
+}
+
+void Cell::setDimmed(bool dimmed) {
+    if (m_dimmed == dimmed) return;
+    m_dimmed = dimmed;
+    update();
+}
+
+void Cell::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    if (!m_dimmed && !isSelected() && brush() == m_originalBrush && pen() == m_originalPen) {
+        return;   // TerrainLayer already drew exactly this
+    }
+    TM_PROFILE_COUNT(CellsRepainted, 1);
+
+    // Highlight brushes are translucent and were chosen to sit on white, not
+    // on the terrain drawn underneath
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(Qt::white);
+    painter->drawPolygon(polygon());
+
+    const double scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (scale >= BoardNavigator::DetailScale) {
+        QGraphicsPolygonItem::paint(painter, option, widget);
+    } else {
+        // Zoomed out: outlines would be a pixel or less, so a plain tile
+        painter->setBrush(brush());
+        painter->drawPolygon(polygon());
+    }
+
+    if (m_dimmed) {
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(QColor(255, 255, 255, 166));   // What 35% opacity on white looked like
+        painter->drawPolygon(polygon());
+    }
 }
@@ -1,16 +1,17 @@
 #ifndef CELL_H
 #define CELL_H
 
-#include <QObject>
 #include <QGraphicsPolygonItem>
 #include <QPointF>
 #include <qbrush.h>
 #include <qpen.h>
 
 class Agent;
+class HexBoard;
 
-class Cell : public QObject, public QGraphicsPolygonItem {
-    Q_OBJECT
+// Not a QObject: input reaches cells through BoardNavigator as indices, so
+// a cell is just the item and its game data
+class Cell : public QGraphicsPolygonItem {
 public:
     enum CellType {
         Normal,
@@ -21,7 +22,19 @@ public:
 
     Cell(int row, int col, CellType type, QGraphicsItem* parent = nullptr);
 
+    // The board layout, both ways: where a cell's centre goes, and the index
+    // of the board's cell whose hex covers a scene point (-1 in the gaps
+    // between hexes and off the board). Arithmetic only, so picking costs
+    // the same on any size of map.
+    static QPointF centerAt(int row, int col);
+    static int hexAt(const QPointF& scenePos, const HexBoard& board);
+
     void resetBrush();
+    static QBrush terrainBrush(CellType type);
+
+    // Fog of war: washed out towards white, as if seen through haze
+    void setDimmed(bool dimmed);
+    bool isDimmed() const { return m_dimmed; }
 
     // Getters
     QPointF getCenter() const;
@@ -30,9 +43,11 @@ public:
     Agent* getAgent() const;
     int getRow() const;
     int getCol() const;
+    int getIndex() const;
 
     // Setters
     void setAgent(Agent* agent);
+    void setIndex(int index);
 
     // Game logic
     int distanceTo(Cell* other) const;
@@ -44,11 +59,13 @@ public:
     void clearHighlight();
     void setPlacementHint(bool canPlace);
 
-signals:
-    void clicked(Cell* cell);
+    // A fixed rect around the hex with room for the widest highlight pen, so
+    // the view can cull cells without measuring polygons
+    QRectF boundingRect() const override;
 
-protected:
-    void mousePressEvent(QGraphicsSceneMouseEvent* event) override;
+    // Plain terrain is TerrainLayer's job; a cell paints only while it is
+    // highlighted, selected or dimmed
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
 
 private:
     void createHexagon();
@@ -56,12 +73,14 @@ private:
     CellType m_type;
     int m_row;
     int m_col;
+    int m_index = -1;   // Position in GamePage::m_cells
     QPointF m_center;
     Agent* m_agent = nullptr;
     static const int m_size = 30;
     
     // Visual state tracking
     bool m_isHighlighted = false;
+    bool m_dimmed = false;
     QBrush m_originalBrush;
     QPen m_originalPen;
 };
@@ -0,0 +1,82 @@
+// DistanceField.cpp - Implementation of DistanceField
+#include "DistanceField.h"
+#include <QtAlgorithms>
+#include "TraceRecorder.h"
+
+void DistanceField::compute(const HexBoard& board, const QVector<int>& sources, const QVector<int>& occupant) {
+    TM_TRACE_SPAN("distance field", "ai");
+    const int cells = board.cellCount();
+    const int buckets = MoveCosts::MaxCost + 1;
+    const quint32 allTypes = (1 << TypeCount) - 1;
+    const MoveCosts& costs = MoveCosts::standard();
+    m_distance.fill(Unreachable, cells * TypeCount);
+
+    int pending = 0;
+    for (int source : sources) {
+        if (source < 0 || source >= cells || m_distance[source * TypeCount] == 0) continue;
+        for (int type = 0; type < TypeCount; ++type) m_distance[source * TypeCount + type] = 0;
+        m_buckets[0].append(quint32(source) << 4 | allTypes);
+        ++pending;
+    }
+
+    // The search runs backwards, from the sources out: reaching neighbor from
+    // cell here means an agent on neighbor stepping onto cell, which costs
+    // what cell's terrain costs its type
+    for (int distance = 0; pending > 0 && distance < Unreachable; ++distance) {
+        QVector<quint32>& bucket = m_buckets[distance % buckets];
+        for (int i = 0; i < bucket.size(); ++i) {
+            const int cell = int(bucket[i] >> 4);
+            --pending;
+            const HexBoard::Terrain terrain = board.terrain(cell);
+
+            // Only the types still this close (a cheaper entry may have come
+            // later), grouped by what stepping onto cell costs them. Sources
+            // (distance 0) may always be stepped onto; anything else only if
+            // it is free and the type can pass.
+            int stepCost[TypeCount];
+            quint32 types = 0;
+            for (int type = 0; type < TypeCount; ++type) {
+                if (!(bucket[i] & (1 << type)) || m_distance[cell * TypeCount + type] != distance) continue;
+                const int cost = costs.cost(AgentType(type), terrain);
+                if (distance == 0) {
+                    stepCost[type] = qMax(1, cost);
+                } else if (occupant[cell] < 0 && cost > 0) {
+                    stepCost[type] = cost;
+                } else {
+                    continue;
+                }
+                types |= 1 << type;
+            }
+
+            while (types) {
+                const int first = qCountTrailingZeroBits(types);
+                const int cost = stepCost[first];
+                quint32 group = 0;
+                for (int type = first; type < TypeCount; ++type) {
+                    if ((types & (1 << type)) && stepCost[type] == cost) group |= 1 << type;
+                }
+                types &= ~group;
+
+                const int reached = distance + cost;
+                if (reached >= Unreachable) continue;
+                for (const int* it = board.neighborsBegin(cell); it != board.neighborsEnd(cell); ++it) {
+                    const int neighbor = *it;
+                    quint32 improved = 0;
+                    for (int type = first; type < TypeCount; ++type) {
+                        quint8& known = m_distance[neighbor * TypeCount + type];
+                        if ((group & (1 << type)) && known > reached) {
+                            known = quint8(reached);
+                            improved |= 1 << type;
+                        }
+                    }
+                    if (improved) {
+                        m_buckets[reached % buckets].append(quint32(neighbor) << 4 | improved);
+                        ++pending;
+                    }
+                }
+            }
+        }
+        bucket.clear();
+    }
+    for (QVector<quint32>& bucket : m_buckets) bucket.clear();
+}
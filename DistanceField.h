@@ -0,0 +1,38 @@
+// DistanceField.h - Steps to the nearest of a set of cells, for every agent type at once
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <QVector>
+#include "AgentType.h"
+#include "HexBoard.h"
+#include "MoveCosts.h"
+
+// For every cell and agent type: the moves an agent of that type standing
+// there needs to reach the nearest source cell (enemies, goalCells()), with
+// the same rules as MatchState::pathDistance -- steps cost what MoveCosts
+// says, occupied cells block, and a source may always be stepped onto.
+//
+// One Dial's-algorithm sweep out of all sources fills the field for all four
+// types together: each queued entry carries the set of types that reached
+// the cell at that cost, split only where their step costs differ.
+// Distances are a byte each, four per cell, so the field for a 100,000-hex
+// map is 400 KB.
+class DistanceField {
+public:
+    static const quint8 Unreachable = 255;   // Also used for 255 steps or more
+    static const int TypeCount = 4;
+
+    // occupant: agent id per cell, -1 when empty (see MatchState::agentAt)
+    void compute(const HexBoard& board, const QVector<int>& sources, const QVector<int>& occupant);
+
+    int cellCount() const { return m_distance.size() / TypeCount; }
+    quint8 at(int cell, AgentType type) const { return m_distance[cell * TypeCount + type]; }
+
+private:
+    QVector<quint8> m_distance;   // TypeCount entries per cell
+
+    // Scratch space, kept so recomputing doesn't allocate
+    QVector<quint32> m_buckets[MoveCosts::MaxCost + 1];   // Cell << 4 | types
+};
+
+#endif // DISTANCEFIELD_H
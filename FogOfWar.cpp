@@ -0,0 +1,51 @@
+// FogOfWar.cpp - Implementation of FogOfWar
+#include "FogOfWar.h"
+
+static_assert(FogOfWar::SightRadius <= HexBoard::SightRange, "Sight radius beyond the precomputed disk");
+
+FogOfWar::FogOfWar(QSharedPointer<const HexBoard> board, bool lineOfSight) {
+    reset(board, lineOfSight);
+}
+
+void FogOfWar::reset(QSharedPointer<const HexBoard> board, bool lineOfSight) {
+    m_board = board;
+    m_lineOfSight = lineOfSight;
+    clear();
+}
+
+void FogOfWar::clear() {
+    const int cells = m_board ? m_board->cellCount() : 0;
+    for (int player = 0; player < 2; ++player) {
+        m_viewers[player].fill(0, cells);
+        m_bits[player].fill(0, (cells + 63) / 64);
+    }
+}
+
+void FogOfWar::addViewer(int playerIndex, int cell) {
+    if (cell < 0) return;
+    m_board->cellsInSight(cell, SightRadius, m_lineOfSight, m_sight);
+    for (int seen : m_sight) adjust(playerIndex, seen, 1);
+}
+
+void FogOfWar::removeViewer(int playerIndex, int cell) {
+    if (cell < 0) return;
+    m_board->cellsInSight(cell, SightRadius, m_lineOfSight, m_sight);
+    for (int seen : m_sight) adjust(playerIndex, seen, -1);
+}
+
+void FogOfWar::moveViewer(int playerIndex, int fromCell, int toCell) {
+    if (fromCell == toCell) return;
+    // Adding first keeps the overlap's counts above zero, so cells seen
+    // from both ends never flip off and on again
+    addViewer(playerIndex, toCell);
+    removeViewer(playerIndex, fromCell);
+}
+
+void FogOfWar::adjust(int playerIndex, int cell, int delta) {
+    quint8& viewers = m_viewers[playerIndex][cell];
+    const bool wasVisible = viewers > 0;
+    viewers = quint8(viewers + delta);
+    if ((viewers > 0) != wasVisible) {
+        m_bits[playerIndex][cell >> 6] ^= quint64(1) << (cell & 63);
+    }
+}
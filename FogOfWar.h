@@ -0,0 +1,45 @@
+// FogOfWar.h - Per-player visible cells, updated as agents come and go
+#ifndef FOGOFWAR_H
+#define FOGOFWAR_H
+
+#include <QSharedPointer>
+#include <QVector>
+#include "HexBoard.h"
+
+// Each player sees the cells within SightRadius of any of their agents (with
+// the line of sight rule, minus what Rock hides). Every cell keeps a count
+// of the player's agents that see it, so an agent appearing, moving or dying
+// touches only its own sight disk; the union is never rebuilt.
+//
+// isVisible() is a bit test on a per-player bitset; a view can XOR the
+// bitset against what it last drew to find the few cells to redraw.
+class FogOfWar {
+public:
+    static const int SightRadius = 3;   // At most HexBoard::SightRange
+
+    FogOfWar() = default;
+    FogOfWar(QSharedPointer<const HexBoard> board, bool lineOfSight);
+
+    void reset(QSharedPointer<const HexBoard> board, bool lineOfSight);
+    void clear();   // Nobody sees anything
+
+    void addViewer(int playerIndex, int cell);
+    void removeViewer(int playerIndex, int cell);
+    void moveViewer(int playerIndex, int fromCell, int toCell);   // Either may be -1
+
+    bool isVisible(int playerIndex, int cell) const {
+        return (m_bits[playerIndex][cell >> 6] >> (cell & 63)) & 1;
+    }
+    const QVector<quint64>& bits(int playerIndex) const { return m_bits[playerIndex]; }
+
+private:
+    void adjust(int playerIndex, int cell, int delta);
+
+    QSharedPointer<const HexBoard> m_board;
+    bool m_lineOfSight = false;
+    QVector<quint8> m_viewers[2];   // Agents seeing each cell
+    QVector<quint64> m_bits[2];     // m_viewers > 0, 64 cells a word
+    QVector<int> m_sight;           // Scratch buffer for HexBoard::cellsInSight
+};
+
+#endif // FOGOFWAR_H
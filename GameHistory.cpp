@@ -0,0 +1,33 @@
+// GameHistory.cpp - Implementation of GameHistory
+#include "GameHistory.h"
+
+GameHistory::GameHistory(int maxDepth) : m_maxDepth(maxDepth) {
+}
+
+void GameHistory::push(const GameDelta& delta) {
+    if (delta.isEmpty()) return;
+
+    m_deltas.resize(m_position);
+    m_deltas.append(delta);
+
+    // Forget the oldest actions once the history is full
+    if (m_deltas.size() > m_maxDepth) {
+        m_deltas.remove(0, m_deltas.size() - m_maxDepth);
+    }
+    m_position = m_deltas.size();
+}
+
+void GameHistory::clear() {
+    m_deltas.clear();
+    m_position = 0;
+}
+
+const GameDelta& GameHistory::stepBack() {
+    Q_ASSERT(canUndo());
+    return m_deltas[--m_position];
+}
+
+const GameDelta& GameHistory::stepForward() {
+    Q_ASSERT(canRedo());
+    return m_deltas[m_position++];
+}
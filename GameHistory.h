@@ -0,0 +1,50 @@
+// GameHistory.h - Incremental state deltas for undo/redo of battle actions
+#ifndef GAMEHISTORY_H
+#define GAMEHISTORY_H
+
+#include <QVector>
+
+// State change of a single agent caused by one action. Agents are identified
+// by their roster index (player 1's agents first, then player 2's), the same
+// order GameSnapshot uses. A cell of -1 means "not on the board" (dead).
+struct AgentDelta {
+    int agentId = -1;
+    int cellBefore = -1;
+    int cellAfter = -1;
+    int hpBefore = 0;
+    int hpAfter = 0;
+    int movesBefore = 0;
+    int movesAfter = 0;
+};
+
+// Everything one action changed: only the agents that differ, plus the turn
+struct GameDelta {
+    QVector<AgentDelta> agents;
+    int playerBefore = 0;   // 0 = player 1, 1 = player 2
+    int playerAfter = 0;
+
+    bool isEmpty() const { return agents.isEmpty() && playerBefore == playerAfter; }
+};
+
+class GameHistory {
+public:
+    explicit GameHistory(int maxDepth = 256);
+
+    // Recording a new action discards anything that could still be redone
+    void push(const GameDelta& delta);
+    void clear();
+
+    bool canUndo() const { return m_position > 0; }
+    bool canRedo() const { return m_position < m_deltas.size(); }
+
+    // Step the cursor and return the delta to apply (backwards for undo)
+    const GameDelta& stepBack();
+    const GameDelta& stepForward();
+
+private:
+    QVector<GameDelta> m_deltas;
+    int m_position = 0;
+    int m_maxDepth;
+};
+
+#endif // GAMEHISTORY_H
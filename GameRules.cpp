@@ -0,0 +1,69 @@
+// GameRules.cpp - Implementation of GameRules and RangeSearch
+#include "GameRules.h"
+
+bool GameRules::canPlaceOn(AgentType type, HexBoard::Terrain terrain) {
+    switch (type) {
+    case WaterWalking:
+        return terrain == HexBoard::Water || terrain == HexBoard::Normal || terrain == HexBoard::Goal;
+    case Grounded:
+    case Flying:
+        return terrain == HexBoard::Normal || terrain == HexBoard::Goal;
+    case Floating:
+        return true;
+    }
+    return false;
+}
+
+int RangeSearch::start(const HexBoard& board, int center) {
+    const int cells = board.cellCount();
+    if (m_mark.size() != cells || ++m_stamp <= 0) {
+        m_mark.fill(0, cells);
+        m_distance.resize(cells);
+        m_stamp = 1;
+    }
+    m_queue.clear();
+    m_queue.append(center);
+    m_mark[center] = m_stamp;
+    m_distance[center] = 0;
+    return m_stamp;
+}
+
+const QVector<int>& RangeSearch::run(const HexBoard& board, int center, int range) {
+    m_cells.clear();
+    if (center < 0 || range <= 0) return m_cells;
+
+    const int stamp = start(board, center);
+    for (int head = 0; head < m_queue.size(); ++head) {
+        const int cell = m_queue[head];
+        if (m_distance[cell] > 0) m_cells.append(cell);
+        if (m_distance[cell] >= range) continue;
+
+        for (const int* it = board.neighborsBegin(cell); it != board.neighborsEnd(cell); ++it) {
+            if (m_mark[*it] != stamp) {
+                m_mark[*it] = stamp;
+                m_distance[*it] = m_distance[cell] + 1;
+                m_queue.append(*it);
+            }
+        }
+    }
+    return m_cells;
+}
+
+bool RangeSearch::reaches(const HexBoard& board, int center, int target, int range) {
+    if (center < 0 || target < 0 || center == target || range <= 0) return false;
+
+    const int stamp = start(board, center);
+    for (int head = 0; head < m_queue.size(); ++head) {
+        const int cell = m_queue[head];
+        if (m_distance[cell] >= range) continue;
+
+        for (const int* it = board.neighborsBegin(cell); it != board.neighborsEnd(cell); ++it) {
+            if (m_mark[*it] == stamp) continue;
+            if (*it == target) return true;
+            m_mark[*it] = stamp;
+            m_distance[*it] = m_distance[cell] + 1;
+            m_queue.append(*it);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,125 @@
+// GameRules.h - The board rules GamePage and MatchState both play by
+#ifndef GAMERULES_H
+#define GAMERULES_H
+
+#include <QVector>
+#include "AgentType.h"
+#include "HexBoard.h"
+#include "Lockstep.h"
+#include "MoveCosts.h"
+
+// One copy of the rules, on cell indices, for GamePage (scene items) and
+// MatchState (plain data) alike. Whoever holds the agents says where they
+// stand through occupied(cell), true when an agent is on the cell.
+class GameRules {
+public:
+    // Where each type may stand, after placement or a move
+    static bool canPlaceOn(AgentType type, HexBoard::Terrain terrain);
+    // Where each type may pass: anything with a move cost (see MoveCosts.h)
+    static bool canMoveThrough(AgentType type, HexBoard::Terrain terrain) {
+        return MoveCosts::standard().canPass(type, terrain);
+    }
+
+    // Cheapest moves from start through free cells, within budget (-1 = no
+    // limit). The costs and paths are left in search.
+    template <typename Occupied>
+    static void searchMoves(MoveSearch& search, const HexBoard& board, AgentType type, int start, int budget,
+                            Occupied occupied);
+
+    // What moving from start to target costs, or -1 if the move isn't legal
+    // (target taken, not a place to stand, or beyond budget). The path is
+    // left in search: follow parent() back from target.
+    template <typename Occupied>
+    static int moveCost(MoveSearch& search, const HexBoard& board, AgentType type, int start, int target,
+                        int budget, Occupied occupied);
+
+    // Cheapest cost from start to target, which may be occupied and costs
+    // at least one move to step onto; MoveSearch::Unreached if there's no way
+    template <typename Occupied>
+    static int pathCost(MoveSearch& search, const HexBoard& board, AgentType type, int start, int target,
+                        Occupied occupied);
+
+    // An attack: the target takes the attacker's damage, the attacker
+    // counterDamage() of it, and an attacker still alive lands on
+    // landingCell() next to a target still standing
+    static int counterDamage(int damage) { return damage / 2; }
+
+    // A random free neighbour of targetCell the attacker can stand on, or -1
+    template <typename Occupied>
+    static int landingCell(const HexBoard& board, AgentType type, int targetCell, LockstepRandom& random,
+                           Occupied occupied);
+
+    // Who moves once currentPlayer's turn ends. Their living agents get
+    // their full mobility back.
+    static int nextPlayer(int currentPlayer) { return 1 - currentPlayer; }
+};
+
+// Attack range: cells within range steps of a centre, terrain and agents
+// ignored. Keep one around and reuse it; cells are marked with a stamp, so
+// a query touches only the cells in range and allocates nothing.
+class RangeSearch {
+public:
+    // Cells within range of center, nearest first, center excluded
+    const QVector<int>& run(const HexBoard& board, int center, int range);
+    // Whether target is within range of center; stops once it is found
+    bool reaches(const HexBoard& board, int center, int target, int range);
+
+private:
+    int start(const HexBoard& board, int center);
+
+    QVector<int> m_mark;        // Stamp: queued in this query
+    QVector<int> m_distance;
+    QVector<int> m_queue;
+    QVector<int> m_cells;
+    int m_stamp = 0;
+};
+
+template <typename Occupied>
+void GameRules::searchMoves(MoveSearch& search, const HexBoard& board, AgentType type, int start, int budget,
+                            Occupied occupied) {
+    const MoveCosts& costs = MoveCosts::standard();
+    search.run(board, start, budget, [&](int cell) {
+        return occupied(cell) ? 0 : costs.cost(type, board.terrain(cell));
+    });
+}
+
+template <typename Occupied>
+int GameRules::moveCost(MoveSearch& search, const HexBoard& board, AgentType type, int start, int target,
+                        int budget, Occupied occupied) {
+    if (start < 0 || target < 0 || budget <= 0 || occupied(target)) return -1;
+    if (!canPlaceOn(type, board.terrain(target))) return -1;
+
+    const MoveCosts& costs = MoveCosts::standard();
+    search.run(board, start, budget, [&](int cell) {
+        return occupied(cell) ? 0 : costs.cost(type, board.terrain(cell));
+    }, target);
+    return search.cost(target) == MoveSearch::Unreached ? -1 : search.cost(target);
+}
+
+template <typename Occupied>
+int GameRules::pathCost(MoveSearch& search, const HexBoard& board, AgentType type, int start, int target,
+                        Occupied occupied) {
+    const MoveCosts& costs = MoveCosts::standard();
+    search.run(board, start, -1, [&](int cell) {
+        const int cost = costs.cost(type, board.terrain(cell));
+        if (cell == target) return qMax(1, cost);
+        return occupied(cell) ? 0 : cost;
+    }, target);
+    return search.cost(target);
+}
+
+template <typename Occupied>
+int GameRules::landingCell(const HexBoard& board, AgentType type, int targetCell, LockstepRandom& random,
+                           Occupied occupied) {
+    if (targetCell < 0) return -1;
+    int available[6];
+    int count = 0;
+    for (const int* it = board.neighborsBegin(targetCell); it != board.neighborsEnd(targetCell); ++it) {
+        if (count < 6 && !occupied(*it) && canPlaceOn(type, board.terrain(*it))) {
+            available[count++] = *it;
+        }
+    }
+    return count > 0 ? available[random.bounded(count)] : -1;
+}
+
+#endif // GAMERULES_H
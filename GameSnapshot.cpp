@@ -0,0 +1,198 @@
+// GameSnapshot.cpp - Implementation of GameSnapshot
+#include "GameSnapshot.h"
+#include "AgentType.h"
+#include "HexBoard.h"
+#include <cstring>
+
+static_assert(sizeof(GameSnapshot::Header) % 4 == 0, "Header must keep records aligned");
+static_assert(sizeof(GameSnapshot::CellRecord) % 4 == 0, "CellRecord must keep records aligned");
+static_assert(sizeof(GameSnapshot::AgentRecord) % 4 == 0, "AgentRecord must keep records aligned");
+
+QByteArray GameSnapshot::write(const QString& mapName, int currentPlayer, Phase phase,
+                               const QVector<CellState>& cells,
+                               const QVector<AgentState>& agents, int rules)
+{
+    // Encode names first so the total size is known up front
+    QVector<QByteArray> names;
+    names.reserve(agents.size());
+    quint32 nameBytes = 0;
+    for (const AgentState& agent : agents) {
+        names.append(agent.name.toUtf8());
+        nameBytes += quint32(names.last().size());
+    }
+
+    const int cellBytes = cells.size() * int(sizeof(CellRecord));
+    const int agentBytes = agents.size() * int(sizeof(AgentRecord));
+    const int totalSize = int(sizeof(Header)) + cellBytes + agentBytes + int(nameBytes);
+
+    QByteArray blob(totalSize, '\0');
+    char* out = blob.data();
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = Magic;
+    header.version = Version;
+    header.headerSize = sizeof(Header);
+    header.totalSize = quint32(totalSize);
+    header.cellCount = quint32(cells.size());
+    header.agentCount = quint32(agents.size());
+    header.nameBytes = nameBytes;
+    header.currentPlayer = quint8(currentPlayer);
+    header.phase = phase;
+    header.rules = quint8(rules);
+    const QByteArray map = mapName.toUtf8().left(int(sizeof(header.mapName)) - 1);
+    std::memcpy(header.mapName, map.constData(), size_t(map.size()));
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (const CellState& cell : cells) {
+        CellRecord record;
+        record.row = qint16(cell.row);
+        record.col = qint16(cell.col);
+        record.type = quint8(cell.type);
+        record.zone = quint8(cell.zone);
+        record.reserved = 0;
+        std::memcpy(out, &record, sizeof(record));
+        out += sizeof(record);
+    }
+
+    quint32 nameOffset = 0;
+    for (int i = 0; i < agents.size(); ++i) {
+        const AgentState& agent = agents[i];
+        AgentRecord record;
+        record.cellIndex = agent.cellIndex;
+        record.currentHP = agent.currentHP;
+        record.maxHP = agent.maxHP;
+        record.mobility = qint16(agent.mobility);
+        record.remainingMoves = qint16(agent.remainingMoves);
+        record.damage = qint16(agent.damage);
+        record.attackRange = qint16(agent.attackRange);
+        record.owner = quint8(agent.owner);
+        record.type = quint8(agent.type);
+        record.nameLength = quint16(names[i].size());
+        record.nameOffset = nameOffset;
+        std::memcpy(out, &record, sizeof(record));
+        out += sizeof(record);
+        nameOffset += record.nameLength;
+    }
+
+    for (const QByteArray& name : names) {
+        std::memcpy(out, name.constData(), size_t(name.size()));
+        out += name.size();
+    }
+
+    return blob;
+}
+
+GameSnapshot::GameSnapshot(const QByteArray& blob) : m_blob(blob)
+{
+    if (m_blob.size() < int(sizeof(Header))) {
+        fail("Snapshot is truncated");
+        return;
+    }
+
+    // Records are read in place, so the buffer must be suitably aligned.
+    // QByteArray storage always is in practice; copy once if it is not.
+    if (reinterpret_cast<quintptr>(m_blob.constData()) % alignof(Header) != 0) {
+        m_blob = QByteArray(blob.constData(), blob.size());
+    }
+
+    const char* base = m_blob.constData();
+    const Header* header = reinterpret_cast<const Header*>(base);
+
+    if (header->magic != Magic) {
+        fail("Not a snapshot (bad magic or byte order)");
+        return;
+    }
+    if (header->version != Version || header->headerSize != sizeof(Header)) {
+        fail(QString("Unsupported snapshot version %1").arg(header->version));
+        return;
+    }
+
+    const qint64 expected = qint64(sizeof(Header))
+                            + qint64(header->cellCount) * qint64(sizeof(CellRecord))
+                            + qint64(header->agentCount) * qint64(sizeof(AgentRecord))
+                            + qint64(header->nameBytes);
+    if (header->totalSize != quint32(m_blob.size()) || expected != m_blob.size()) {
+        fail("Snapshot size does not match its header");
+        return;
+    }
+
+    m_cells = reinterpret_cast<const CellRecord*>(base + sizeof(Header));
+    m_agents = reinterpret_cast<const AgentRecord*>(m_cells + header->cellCount);
+    m_names = reinterpret_cast<const char*>(m_agents + header->agentCount);
+
+    for (quint32 i = 0; i < header->agentCount; ++i) {
+        const AgentRecord& record = m_agents[i];
+        if (quint64(record.nameOffset) + record.nameLength > header->nameBytes) {
+            fail("Snapshot agent name out of range");
+            return;
+        }
+    }
+
+    m_header = header;
+}
+
+QString GameSnapshot::mapName() const {
+    if (!m_header) return QString();
+    return QString::fromUtf8(m_header->mapName, int(qstrnlen(m_header->mapName, sizeof(m_header->mapName))));
+}
+
+QString GameSnapshot::agentName(int index) const {
+    const AgentRecord& record = m_agents[index];
+    return QString::fromUtf8(m_names + record.nameOffset, record.nameLength);
+}
+
+bool GameSnapshot::check(const HexBoard& board, QString* error) const {
+    if (!m_header) {
+        if (error) *error = m_error;
+        return false;
+    }
+    if (cellCount() != board.cellCount()) {
+        if (error) *error = QString("map %1 has %2 cells, snapshot has %3").arg(board.name()).arg(board.cellCount())
+                                .arg(cellCount());
+        return false;
+    }
+    for (int i = 0; i < cellCount(); ++i) {
+        if (m_cells[i].type != board.terrain(i)) {
+            if (error) *error = QString("cell %1 terrain differs from map %2").arg(i).arg(board.name());
+            return false;
+        }
+    }
+    if (m_header->currentPlayer > 1) {
+        if (error) *error = QString("player %1 to move").arg(int(m_header->currentPlayer));
+        return false;
+    }
+
+    QVector<bool> taken(board.cellCount(), false);
+    for (int i = 0; i < agentCount(); ++i) {
+        const AgentRecord& record = m_agents[i];
+        if (record.type > Floating || record.owner > 1) {
+            if (error) *error = QString("agent %1 has type %2, owner %3").arg(i).arg(int(record.type))
+                                    .arg(int(record.owner));
+            return false;
+        }
+        if (record.cellIndex < -1 || record.cellIndex >= board.cellCount()) {
+            if (error) *error = QString("agent %1 is on cell %2 of %3").arg(i).arg(record.cellIndex)
+                                    .arg(board.cellCount());
+            return false;
+        }
+        if (record.cellIndex >= 0 && record.currentHP > 0) {
+            if (taken[record.cellIndex]) {
+                if (error) *error = QString("two agents on cell %1").arg(record.cellIndex);
+                return false;
+            }
+            taken[record.cellIndex] = true;
+        }
+    }
+    return true;
+}
+
+bool GameSnapshot::fail(const QString& error) {
+    m_error = error;
+    m_header = nullptr;
+    m_cells = nullptr;
+    m_agents = nullptr;
+    m_names = nullptr;
+    return false;
+}
@@ -0,0 +1,130 @@
+// GameSnapshot.h - Flat, versioned binary snapshot of a match in progress
+#ifndef GAMESNAPSHOT_H
+#define GAMESNAPSHOT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class HexBoard;
+
+// Blob layout (native byte order, every record 4-byte aligned):
+//   [Header][CellRecord x cellCount][AgentRecord x agentCount][agent name bytes]
+//
+// Loading does not unpack anything: the reader keeps a (shared) reference to
+// the blob and hands out pointers straight into it, so a save/restore round
+// trip is a single memcpy on write and a few pointer checks on read.
+class GameSnapshot {
+public:
+    static constexpr quint32 Magic = 0x4E534D54;   // "TMSN"
+    static constexpr quint16 Version = 1;
+
+    enum Phase : quint8 {
+        Placement = 0,
+        Battle = 1
+    };
+
+    // Optional rules the match is played with, or-ed into Header::rules.
+    // Older snapshots have zero there: every rule off.
+    enum Rule : quint8 {
+        LineOfSight = 0x01,     // Rock blocks attacks (HexBoard::isVisible)
+        Fog = 0x02              // Fog of war (FogOfWar)
+    };
+
+    struct Header {
+        quint32 magic;
+        quint16 version;
+        quint16 headerSize;
+        quint32 totalSize;
+        quint32 cellCount;
+        quint32 agentCount;
+        quint32 nameBytes;
+        quint8 currentPlayer;   // 0 = player 1, 1 = player 2
+        quint8 phase;           // Phase
+        quint8 rules;           // Rule flags
+        quint8 reserved;
+        char mapName[32];       // Zero padded, e.g. "grid3.txt"
+    };
+
+    struct CellRecord {
+        qint16 row;
+        qint16 col;
+        quint8 type;            // Cell::CellType
+        quint8 zone;            // 0 = none, 1 = player 1, 2 = player 2
+        quint16 reserved;
+    };
+
+    struct AgentRecord {
+        qint32 cellIndex;       // -1 once the agent is dead
+        qint32 currentHP;
+        qint32 maxHP;
+        qint16 mobility;
+        qint16 remainingMoves;
+        qint16 damage;
+        qint16 attackRange;
+        quint8 owner;           // 0 = player 1, 1 = player 2
+        quint8 type;            // AgentType
+        quint16 nameLength;     // UTF-8 bytes
+        quint32 nameOffset;     // Offset into the name area
+    };
+
+    // Input used when writing a snapshot
+    struct AgentState {
+        QString name;
+        int owner = 0;
+        int type = 0;
+        int cellIndex = -1;
+        int currentHP = 0;
+        int maxHP = 0;
+        int mobility = 0;
+        int remainingMoves = 0;
+        int damage = 0;
+        int attackRange = 0;
+    };
+
+    struct CellState {
+        int row = 0;
+        int col = 0;
+        int type = 0;
+        int zone = 0;
+    };
+
+    // Writing
+    static QByteArray write(const QString& mapName, int currentPlayer, Phase phase,
+                            const QVector<CellState>& cells,
+                            const QVector<AgentState>& agents, int rules = 0);
+
+    // Reading (zero-copy view over the blob)
+    GameSnapshot() = default;
+    explicit GameSnapshot(const QByteArray& blob);
+
+    bool isValid() const { return m_header != nullptr; }
+    QString errorString() const { return m_error; }
+    QByteArray data() const { return m_blob; }
+
+    const Header& header() const { return *m_header; }
+    QString mapName() const;
+    int cellCount() const { return m_header ? int(m_header->cellCount) : 0; }
+    int agentCount() const { return m_header ? int(m_header->agentCount) : 0; }
+    const CellRecord& cell(int index) const { return m_cells[index]; }
+    const AgentRecord& agent(int index) const { return m_agents[index]; }
+    QString agentName(int index) const;
+
+    // Whether the snapshot can be played on board: same cells and terrain,
+    // a known player to move, known agent types and owners, and every agent
+    // on the board or off it (-1), one living agent per cell. isValid() only
+    // vouches for the layout; check this before trusting the contents.
+    bool check(const HexBoard& board, QString* error = nullptr) const;
+
+private:
+    bool fail(const QString& error);
+
+    QByteArray m_blob;
+    const Header* m_header = nullptr;
+    const CellRecord* m_cells = nullptr;
+    const AgentRecord* m_agents = nullptr;
+    const char* m_names = nullptr;
+    QString m_error;
+};
+
+#endif // GAMESNAPSHOT_H
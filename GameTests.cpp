@@ -0,0 +1,458 @@
+// GameTests.cpp - Unit tests for board and game logic (Qt Test, run by ctest)
+//
+//   tm_tests                          all tests
+//   tm_tests hexAt                    one test
+#include <cstring>
+#include <QSignalSpy>
+#include <QtMath>
+#include <QtTest>
+#include "AgentRoster.h"
+#include "Cell.h"
+#include "GameRules.h"
+#include "GameSnapshot.h"
+#include "HexBoard.h"
+#include "MapGenerator.h"
+#include "MatchState.h"
+#include "NetworkSession.h"
+
+namespace {
+
+const int HighCell = 3999999;   // Last cell of the largest generated map
+const int ScriptedActions = 150;
+
+// A bundled grid or a generated map ("gen-...")
+QSharedPointer<const HexBoard> loadBoard(const QString& name) {
+    QSharedPointer<const HexBoard> board = MapGenerator::fromName(name);
+    return board ? board : HexBoard::fromFile(":/new/prefix1/" + name, name);
+}
+
+// Three agents a side, placed alternately on the first zone cell each can
+// stand on, then the battle starts
+bool setUpMatch(MatchState& state) {
+    const QVector<AgentDef>& roster = AgentRoster::all();
+    for (int i = 0; i < 6; ++i) {
+        const int player = i % 2;
+        const AgentDef& def = roster[(i * 5) % roster.size()];
+        bool placed = false;
+        for (int cell : state.validPlacementCells(player)) {
+            if (GameRules::canPlaceOn(def.type, state.board().terrain(cell)) && state.placeAgent(player, def, cell)) {
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) return false;
+    }
+    state.startBattle();
+    return true;
+}
+
+// One action for the player to move: the first attack there is, otherwise
+// a move that gets an agent as close to the enemy as it can (ties broken by
+// random). False if the player has nothing to do.
+bool playScripted(MatchState& state, LockstepRandom& random, GameDelta* delta = nullptr) {
+    const QVector<MatchAgent>& agents = state.agents();
+    const int player = state.currentPlayer();
+    QVector<int> enemyCells;
+    for (int id = 0; id < agents.size(); ++id) {
+        if (agents[id].owner == player || !agents[id].isAlive()) continue;
+        enemyCells.append(agents[id].cell);
+        for (int attacker = 0; attacker < agents.size(); ++attacker) {
+            if (agents[attacker].owner == player && state.canAttack(attacker, id)) {
+                return state.performAction(agents[attacker].cell, agents[id].cell, delta);
+            }
+        }
+    }
+
+    DistanceField field;
+    state.distancesTo(enemyCells, field);
+    QVector<QPair<int, int>> best;   // (from, to)
+    int bestDistance = DistanceField::Unreachable + 1;
+    for (int id = 0; id < agents.size(); ++id) {
+        if (agents[id].owner != player || !agents[id].isAlive()) continue;
+        for (int cell : state.reachableCells(id)) {
+            const int distance = field.at(cell, agents[id].type);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best.clear();
+            }
+            if (distance == bestDistance) best.append(qMakePair(agents[id].cell, cell));
+        }
+    }
+    if (best.isEmpty()) return false;
+    const QPair<int, int> move = best[random.bounded(best.size())];
+    return state.performAction(move.first, move.second, delta);
+}
+
+// Visibility from scratch: every cell in sight of a living agent
+void compareFog(const MatchState& state) {
+    const HexBoard& board = state.board();
+    QVector<int> sight;
+    for (int player = 0; player < 2; ++player) {
+        QVector<bool> seen(board.cellCount(), false);
+        for (const MatchAgent& agent : state.agents()) {
+            if (agent.owner != player || !agent.isAlive()) continue;
+            board.cellsInSight(agent.cell, FogOfWar::SightRadius, state.lineOfSight(), sight);
+            for (int cell : sight) seen[cell] = true;
+        }
+        for (int cell = 0; cell < board.cellCount(); ++cell) {
+            QCOMPARE(state.isVisibleTo(player, cell), bool(seen[cell]));
+        }
+    }
+}
+
+// Threat from scratch: for each agent, every cell it could attack from a
+// cell it can reach this turn (the player to move) or next turn (the other)
+void compareThreats(const MatchState& state) {
+    const HexBoard& board = state.board();
+    QVector<int> count[2] = { QVector<int>(board.cellCount(), 0), QVector<int>(board.cellCount(), 0) };
+    QVector<int> damage[2] = { QVector<int>(board.cellCount(), 0), QVector<int>(board.cellCount(), 0) };
+    MoveSearch search;
+    RangeSearch range;
+    QVector<int> sight;
+    for (const MatchAgent& agent : state.agents()) {
+        if (!agent.isAlive()) continue;
+        const int moves = agent.owner == state.currentPlayer() ? agent.remainingMoves : agent.mobility;
+        GameRules::searchMoves(search, board, agent.type, agent.cell, qMax(0, moves),
+                               [&](int cell) { return state.agentAt(cell) >= 0; });
+
+        QVector<bool> hit(board.cellCount(), false);
+        for (int stand : search.settled()) {
+            if (stand != agent.cell && !GameRules::canPlaceOn(agent.type, board.terrain(stand))) continue;
+            if (state.lineOfSight()) {
+                board.cellsInSight(stand, qMin(agent.attackRange, int(HexBoard::SightRange)), true, sight);
+                for (int cell : sight) hit[cell] = true;
+            } else {
+                hit[stand] = true;
+                for (int cell : range.run(board, stand, agent.attackRange)) hit[cell] = true;
+            }
+        }
+        hit[agent.cell] = false;
+
+        for (int cell = 0; cell < board.cellCount(); ++cell) {
+            if (!hit[cell]) continue;
+            ++count[agent.owner][cell];
+            damage[agent.owner][cell] += agent.damage;
+        }
+    }
+
+    for (int player = 0; player < 2; ++player) {
+        for (int cell = 0; cell < board.cellCount(); ++cell) {
+            QCOMPARE(state.threats().threatCount(player, cell), count[player][cell]);
+            QCOMPARE(state.threats().threatDamage(player, cell), damage[player][cell]);
+        }
+    }
+}
+
+// A copy of blob with one field of agent agentId overwritten
+template <typename Field>
+QByteArray patchAgent(const QByteArray& blob, int agentId, Field GameSnapshot::AgentRecord::*field, Field value) {
+    QByteArray patched = blob;
+    const GameSnapshot snapshot(blob);
+    const int offset = int(sizeof(GameSnapshot::Header)) + snapshot.cellCount() * int(sizeof(GameSnapshot::CellRecord))
+                       + agentId * int(sizeof(GameSnapshot::AgentRecord));
+    GameSnapshot::AgentRecord record = snapshot.agent(agentId);
+    record.*field = value;
+    std::memcpy(patched.data() + offset, &record, sizeof(record));
+    return patched;
+}
+
+// Distances from scratch: one path search per cell, type and source, with
+// player 1's agents and the goals as sources
+void compareDistances(const MatchState& state) {
+    const HexBoard& board = state.board();
+    QVector<int> sources = board.goalCells();
+    for (const MatchAgent& agent : state.agents()) {
+        if (agent.owner == 0 && agent.isAlive()) sources.append(agent.cell);
+    }
+    DistanceField field;
+    state.distancesTo(sources, field);
+    QCOMPARE(field.cellCount(), board.cellCount());
+
+    MoveSearch search;
+    const auto occupied = [&](int cell) { return state.agentAt(cell) >= 0; };
+    for (int type = 0; type < DistanceField::TypeCount; ++type) {
+        for (int cell = 0; cell < board.cellCount(); ++cell) {
+            int expected = sources.contains(cell) ? 0 : int(DistanceField::Unreachable);
+            for (int source : sources) {
+                if (expected == 0) break;
+                const int cost = GameRules::pathCost(search, board, AgentType(type), cell, source, occupied);
+                if (cost != MoveSearch::Unreached) expected = qMin(expected, cost);
+            }
+            QCOMPARE(int(field.at(cell, AgentType(type))), expected);
+        }
+    }
+}
+
+}
+
+class GameTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void hexAt_data();
+    void hexAt();
+    void rangeSearch();
+    void deltaRoundTrip();
+    void messageRoundTrip();
+    void scriptedPlay_data();
+    void scriptedPlay();
+    void snapshotRoundTrip();
+    void undoRedo();
+    void lockstepAgreement();
+};
+
+void GameTests::hexAt_data() {
+    QTest::addColumn<QString>("path");
+    for (int i = 1; i <= 8; ++i) {
+        const QString name = QString("grid%1").arg(i);
+        QTest::newRow(qPrintable(name)) << QString(":/new/prefix1/%1.txt").arg(name);
+    }
+}
+
+// Clicks at the centre of every cell and around it, just inside the hex,
+// must all pick that cell
+void GameTests::hexAt() {
+    QFETCH(QString, path);
+    QSharedPointer<const HexBoard> board = HexBoard::fromFile(path, path);
+    QVERIFY(board);
+    QVERIFY(board->cellCount() > 0);
+
+    const double reach = 0.8 * 0.8660254 * 30; // Inside the inscribed circle
+    for (int index = 0; index < board->cellCount(); ++index) {
+        const QPointF center = Cell::centerAt(board->row(index), board->col(index));
+        QCOMPARE(Cell::hexAt(center, *board), index);
+        for (int step = 0; step < 12; ++step) {
+            const double angle = step * M_PI / 6;
+            const QPointF point = center + QPointF(qCos(angle), qSin(angle)) * reach;
+            QCOMPARE(Cell::hexAt(point, *board), index);
+        }
+    }
+}
+
+// reaches() stops early; it must agree with the full run() everywhere
+void GameTests::rangeSearch() {
+    QSharedPointer<const HexBoard> board = HexBoard::fromFile(":/new/prefix1/grid1.txt", "grid1.txt");
+    QVERIFY(board);
+
+    RangeSearch search;
+    for (int range = 0; range <= 3; ++range) {
+        for (int center = 0; center < board->cellCount(); ++center) {
+            const QVector<int> cells = search.run(*board, center, range);
+            QVERIFY(!cells.contains(center));
+            for (int target = 0; target < board->cellCount(); ++target) {
+                QCOMPARE(search.reaches(*board, center, target, range), cells.contains(target));
+            }
+        }
+    }
+    QCOMPARE(search.run(*board, 0, 1).size(), int(board->neighborsEnd(0) - board->neighborsBegin(0)));
+}
+
+void GameTests::deltaRoundTrip() {
+    GameDelta delta;
+    delta.playerAfter = 1;
+    AgentDelta change;
+    change.agentId = 7;
+    change.cellAfter = HighCell;
+    change.hpAfter = 12;
+    change.movesAfter = 3;
+    delta.agents.append(change);
+    change.agentId = 300;     // Past what a byte holds
+    change.cellAfter = -1;    // Died
+    change.hpAfter = 0;
+    change.movesAfter = 70000;
+    delta.agents.append(change);
+
+    GameDelta decoded;
+    QVERIFY(NetworkSession::decodeDelta(NetworkSession::encodeDelta(delta), decoded));
+    QCOMPARE(decoded.playerAfter, 1);
+    QCOMPARE(decoded.agents.size(), 2);
+    QCOMPARE(decoded.agents[0].agentId, 7);
+    QCOMPARE(decoded.agents[0].cellAfter, HighCell);
+    QCOMPARE(decoded.agents[0].hpAfter, 12);
+    QCOMPARE(decoded.agents[0].movesAfter, 3);
+    QCOMPARE(decoded.agents[1].agentId, 300);
+    QCOMPARE(decoded.agents[1].cellAfter, -1);
+    QCOMPARE(decoded.agents[1].movesAfter, 70000);
+
+    // A count that doesn't match the payload is refused
+    QByteArray truncated = NetworkSession::encodeDelta(delta);
+    truncated.chop(1);
+    QVERIFY(!NetworkSession::decodeDelta(truncated, decoded));
+}
+
+// Cell indices in Action, Place and LockstepAction over a real connection
+void GameTests::messageRoundTrip() {
+    const quint16 port = NetworkSession::DefaultPort + 17;
+    NetworkSession host;
+    NetworkSession client;
+    if (!host.host(port)) QSKIP("Cannot listen on the test port");
+    QSignalSpy hostConnected(&host, &NetworkSession::connected);
+    QSignalSpy clientConnected(&client, &NetworkSession::connected);
+    client.join("127.0.0.1", port);
+    QTRY_VERIFY(hostConnected.count() == 1 && clientConnected.count() == 1);
+
+    QSignalSpy actions(&host, &NetworkSession::actionReceived);
+    QSignalSpy places(&host, &NetworkSession::placeReceived);
+    QSignalSpy lockstepActions(&client, &NetworkSession::lockstepActionReceived);
+    client.sendAction(HighCell, HighCell - 1);
+    client.sendPlace("Billy", HighCell);
+    host.sendLockstepAction(HighCell - 2, HighCell, 0xDEADBEEF);
+
+    QTRY_COMPARE(actions.count(), 1);
+    QCOMPARE(actions[0][0].toInt(), HighCell);
+    QCOMPARE(actions[0][1].toInt(), HighCell - 1);
+    QTRY_COMPARE(places.count(), 1);
+    QCOMPARE(places[0][0].toString(), QString("Billy"));
+    QCOMPARE(places[0][1].toInt(), HighCell);
+    QTRY_COMPARE(lockstepActions.count(), 1);
+    QCOMPARE(lockstepActions[0][0].toInt(), HighCell - 2);
+    QCOMPARE(lockstepActions[0][1].toInt(), HighCell);
+    QCOMPARE(lockstepActions[0][2].toUInt(), 0xDEADBEEFu);
+}
+
+void GameTests::scriptedPlay_data() {
+    QTest::addColumn<QString>("map");
+    QTest::addColumn<bool>("lineOfSight");
+    for (const QString& map : { QString("grid1.txt"), QString("gen-150-7") }) {
+        QTest::newRow(qPrintable(map)) << map << false;
+        QTest::newRow(qPrintable(map + " line of sight")) << map << true;
+    }
+}
+
+// Moves, attacks and deaths; after each action the state kept up to date
+// along the way must match one worked out from scratch
+void GameTests::scriptedPlay() {
+    QFETCH(QString, map);
+    QFETCH(bool, lineOfSight);
+    QSharedPointer<const HexBoard> board = loadBoard(map);
+    QVERIFY(board);
+
+    MatchState state(board, 11);
+    state.setLineOfSight(lineOfSight);
+    state.setFogOfWar(true);
+    state.setThreatTracking(true);
+    QVERIFY(setUpMatch(state));
+    compareFog(state);
+    compareThreats(state);
+    compareDistances(state);
+    if (QTest::currentTestFailed()) return;
+
+    LockstepRandom random(5);
+    int actions = 0;
+    while (actions < ScriptedActions && !state.isGameOver() && playScripted(state, random)) {
+        ++actions;
+        compareFog(state);
+        compareThreats(state);
+        compareDistances(state);
+        if (QTest::currentTestFailed()) return;
+    }
+
+    int deaths = 0;
+    for (const MatchAgent& agent : state.agents()) {
+        if (!agent.isAlive()) ++deaths;
+    }
+    QVERIFY(actions > 0);
+    QVERIFY(deaths > 0);
+}
+
+// A match saved and restored is the same match; a snapshot that doesn't
+// fit the board is refused and changes nothing
+void GameTests::snapshotRoundTrip() {
+    QSharedPointer<const HexBoard> board = loadBoard("grid1.txt");
+    QVERIFY(board);
+    MatchState state(board, 3);
+    state.setLineOfSight(true);
+    QVERIFY(setUpMatch(state));
+    LockstepRandom random(9);
+    for (int i = 0; i < 6 && playScripted(state, random); ++i) {}
+
+    const QByteArray saved = state.toSnapshot();
+    MatchState restored(board);
+    QVERIFY(restored.loadSnapshot(GameSnapshot(saved)));
+    QCOMPARE(restored.toSnapshot(), saved);
+
+    QVector<int> living;
+    for (int id = 0; id < state.agents().size(); ++id) {
+        if (state.agents()[id].isAlive()) living.append(id);
+    }
+    QVERIFY(living.size() >= 2);
+    const int agent = living[0];
+    const QVector<QByteArray> bad = {
+        patchAgent<quint8>(saved, agent, &GameSnapshot::AgentRecord::type, quint8(Floating + 1)),
+        patchAgent<quint8>(saved, agent, &GameSnapshot::AgentRecord::owner, quint8(2)),
+        patchAgent<qint32>(saved, agent, &GameSnapshot::AgentRecord::cellIndex, qint32(board->cellCount())),
+        patchAgent<qint32>(saved, living[1], &GameSnapshot::AgentRecord::cellIndex,   // Two on one cell
+                           qint32(state.agents()[agent].cell)),
+    };
+    for (const QByteArray& blob : bad) {
+        const GameSnapshot snapshot(blob);
+        QVERIFY(snapshot.isValid());
+        QVERIFY(!snapshot.check(*board));
+        QVERIFY(!restored.loadSnapshot(snapshot));
+        QCOMPARE(restored.toSnapshot(), saved);
+    }
+}
+
+// Undoing every action returns to the start; redoing them all returns to
+// the same state and checksum as before the undo
+void GameTests::undoRedo() {
+    QSharedPointer<const HexBoard> board = loadBoard("grid1.txt");
+    QVERIFY(board);
+    MatchState state(board, 4);
+    QVERIFY(setUpMatch(state));
+    const QByteArray start = state.toSnapshot();
+
+    GameHistory history;
+    LockstepRandom random(6);
+    GameDelta delta;
+    for (int i = 0; i < 40 && !state.isGameOver() && playScripted(state, random, &delta); ++i) {
+        history.push(delta);
+    }
+    QVERIFY(history.canUndo());
+    const QByteArray end = state.toSnapshot();
+    const quint32 checksum = state.stateChecksum(0);
+
+    while (history.canUndo()) state.applyDelta(history.stepBack(), true);
+    QCOMPARE(state.toSnapshot(), start);
+    while (history.canRedo()) state.applyDelta(history.stepForward());
+    QCOMPARE(state.toSnapshot(), end);
+    QCOMPARE(state.stateChecksum(0), checksum);
+}
+
+// Peers seeded alike pick the same landing cells, so two matches fed the
+// same actions keep the same rolling checksum
+void GameTests::lockstepAgreement() {
+    QSharedPointer<const HexBoard> board = loadBoard("grid1.txt");
+    QVERIFY(board);
+    LockstepRandom first(42);
+    LockstepRandom second(42);
+    const auto occupied = [](int cell) { return cell % 3 == 0; };
+    for (int round = 0; round < 4; ++round) {
+        for (int cell = 0; cell < board->cellCount(); ++cell) {
+            QCOMPARE(GameRules::landingCell(*board, Grounded, cell, first, occupied),
+                     GameRules::landingCell(*board, Grounded, cell, second, occupied));
+        }
+    }
+    QCOMPARE(first.state(), second.state());
+
+    MatchState host(board, 8);
+    MatchState peer(board, 8);
+    QVERIFY(setUpMatch(host));
+    QVERIFY(setUpMatch(peer));
+    LockstepRandom hostScript(3);
+    LockstepRandom peerScript(3);
+    quint32 hostChecksum = 8;
+    quint32 peerChecksum = 8;
+    for (int i = 0; i < 40 && !host.isGameOver(); ++i) {
+        const bool acted = playScripted(host, hostScript);
+        QCOMPARE(playScripted(peer, peerScript), acted);
+        if (!acted) break;
+        hostChecksum = host.stateChecksum(hostChecksum);
+        peerChecksum = peer.stateChecksum(peerChecksum);
+        QCOMPARE(peerChecksum, hostChecksum);
+    }
+    QCOMPARE(peer.toSnapshot(), host.toSnapshot());
+}
+
+QTEST_GUILESS_MAIN(GameTests)
+#include "GameTests.moc"
@@ -0,0 +1,283 @@
+// HexBoard.cpp - Implementation of HexBoard
+#include "HexBoard.h"
+#include "Log.h"
+#include "TraceRecorder.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+quint64 positionKey(int row, int col) {
+    return (quint64(quint32(row)) << 32) | quint32(col);
+}
+
+struct SightOffset {
+    int row;
+    int col;
+    int distance;   // Hex steps from the centre
+};
+
+// The map-independent half of line of sight: the cells of a hex disk of
+// radius SightRange around a centre, and for each one the cells the hex line
+// to it crosses. Offsets are in the map's own row/col terms (a hex's six
+// neighbours are at (0, +-2) and (+-1, +-1), see buildAdjacency).
+struct SightDisk {
+    static const int Radius = HexBoard::SightRange;
+    static const int Rows = 2 * Radius + 1;
+    static const int Cols = 4 * Radius + 1;
+
+    QVector<SightOffset> cells;
+    QVector<QVector<SightOffset>> between[2];   // Nudged to either side, for lines along a hex edge
+    int lookup[Rows * Cols];                    // (row, col) offset to bit index, -1 outside
+
+    SightDisk() {
+        std::fill(std::begin(lookup), std::end(lookup), -1);
+        for (int r = -Radius; r <= Radius; ++r) {
+            for (int q = -Radius; q <= Radius; ++q) {
+                if (qAbs(q + r) > Radius) continue;
+                const SightOffset offset = {r, 2 * q + r, qMax(qAbs(q), qMax(qAbs(r), qAbs(q + r)))};
+                lookup[(offset.row + Radius) * Cols + offset.col + 2 * Radius] = cells.size();
+                cells.append(offset);
+                between[0].append(line(q, r, 1e-6));
+                between[1].append(line(q, r, -1e-6));
+            }
+        }
+    }
+
+    int bitFor(int row, int col) const {
+        if (qAbs(row) > Radius || qAbs(col) > 2 * Radius) return -1;
+        return lookup[(row + Radius) * Cols + col + 2 * Radius];
+    }
+
+    // Cube-coordinate line drawing from the centre to (q, r), ends excluded
+    static QVector<SightOffset> line(int q, int r, double nudge) {
+        QVector<SightOffset> crossed;
+        const int s = -q - r;
+        const int steps = qMax(qAbs(q), qMax(qAbs(r), qAbs(s)));
+        for (int i = 1; i < steps; ++i) {
+            const double t = double(i) / steps;
+            const double x = q * t + nudge;
+            const double y = r * t + 2 * nudge;
+            const double z = s * t - 3 * nudge;
+            double rx = std::round(x);
+            double ry = std::round(y);
+            double rz = std::round(z);
+            const double dx = std::abs(rx - x);
+            const double dy = std::abs(ry - y);
+            const double dz = std::abs(rz - z);
+            if (dx > dy && dx > dz) rx = -ry - rz;
+            else if (dy > dz) ry = -rx - rz;
+            crossed.append({int(ry), 2 * int(rx) + int(ry), 0});
+        }
+        return crossed;
+    }
+};
+
+static_assert(3 * HexBoard::SightRange * (HexBoard::SightRange + 1) + 1 <= 64,
+              "The sight disk must fit in one quint64 per cell");
+
+const SightDisk& sightDisk() {
+    static const SightDisk disk;
+    return disk;
+}
+
+}
+
+QSharedPointer<const HexBoard> HexBoard::fromFile(const QString& path, const QString& name) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        TM_LOG_WARNING("Cannot open file: %1", path);
+        return QSharedPointer<const HexBoard>();
+    }
+    return fromText(QString::fromUtf8(file.readAll()), name);
+}
+
+QSharedPointer<const HexBoard> HexBoard::fromText(const QString& text, const QString& name) {
+    TM_TRACE_SPAN("parse map", "game");
+    QSharedPointer<HexBoard> board(new HexBoard());
+    board->m_name = name;
+
+    QStringList lines = text.split(QRegularExpression("\r?\n"));
+    while (!lines.isEmpty() && lines.last().trimmed().isEmpty()) {
+        lines.removeLast();
+    }
+
+    // A hex is drawn over two lines ("/xx\" above "\__/"), so the "/  \"
+    // openings on the final line are only the border and never real cells.
+    // The first line is the top border and is row 1, as it always has been.
+    for (int lineIndex = 0; lineIndex + 1 < lines.size(); ++lineIndex) {
+        const QString& line = lines[lineIndex];
+        const int row = lineIndex + 1;
+        for (int col = 0; col + 1 < line.length(); col += 3) {
+            if (line[col] != '/') continue;
+
+            const QString cell = line.mid(col, 2);
+            Terrain terrain = Normal;
+            int zone = 0;
+            if (cell == "/~") terrain = Water;
+            else if (cell == "/#") terrain = Rock;
+            else if (cell == "/*") terrain = Goal;
+            else if (cell == "/1") zone = 1;
+            else if (cell == "/2") zone = 2;
+
+            board->addCell(row, col / 3, terrain, zone);
+        }
+    }
+
+    board->buildAdjacency();
+    return board;
+}
+
+QSharedPointer<const HexBoard> HexBoard::fromCells(const QVector<CellSpec>& cells, const QString& name) {
+    TM_TRACE_SPAN("build map", "game");
+    QSharedPointer<HexBoard> board(new HexBoard());
+    board->m_name = name;
+    board->m_rows.reserve(cells.size());
+    board->m_cols.reserve(cells.size());
+    board->m_terrain.reserve(cells.size());
+    board->m_zones.reserve(cells.size());
+    board->m_indexByPosition.reserve(cells.size());
+    for (const CellSpec& cell : cells) {
+        board->addCell(cell.row, cell.col, cell.terrain, cell.zone);
+    }
+
+    board->buildAdjacency();
+    return board;
+}
+
+void HexBoard::addCell(int row, int col, Terrain terrain, int zone) {
+    const int index = m_rows.size();
+    m_rows.append(row);
+    m_cols.append(col);
+    m_terrain.append(terrain);
+    m_zones.append(quint8(zone));
+    m_indexByPosition.insert(positionKey(row, col), index);
+    if (zone > 0) {
+        m_placementZones[zone - 1].append(index);
+    }
+    if (terrain == Goal) {
+        m_goalCells.append(index);
+    }
+}
+
+int HexBoard::indexAt(int row, int col) const {
+    return m_indexByPosition.value(positionKey(row, col), -1);
+}
+
+void HexBoard::buildAdjacency() {
+    // Hex grid adjacency offsets for neighbor finding (same table and
+    // proximity check GamePage::getAdjacentCells always used)
+    static const int offsets[12][2] = {
+        {-1, 0}, {-1, 1}, {0, 1}, {1, 0}, {0, -1}, {-1, -1},
+        {1, 1}, {1, -1}, {-1, -2}, {-1, 2}, {0, -2}, {0, 2}
+    };
+
+    m_adjacencyStart.resize(cellCount() + 1);
+    m_adjacency.clear();
+    m_adjacency.reserve(cellCount() * 6);
+
+    for (int index = 0; index < cellCount(); ++index) {
+        m_adjacencyStart[index] = m_adjacency.size();
+        const int row = m_rows[index];
+        const int col = m_cols[index];
+
+        for (const auto& offset : offsets) {
+            const int newRow = row + offset[0];
+            const int newCol = col + offset[1];
+            if (newRow < 0 || newCol < 0) continue;
+
+            const int neighbor = indexAt(newRow, newCol);
+            if (neighbor < 0) continue;
+
+            const int dr = qAbs(offset[0]);
+            const int dc = qAbs(offset[1]);
+            if ((dr <= 1 && dc <= 1) || (dr <= 2 && dc == 0) || (dr == 0 && dc <= 2)) {
+                m_adjacency.append(neighbor);
+            }
+        }
+    }
+    m_adjacencyStart[cellCount()] = m_adjacency.size();
+}
+
+const QVector<quint64>& HexBoard::visibility() const {
+    std::call_once(m_visibilityBuilt, [this]() { buildVisibility(); });
+    return m_visibility;
+}
+
+void HexBoard::buildVisibility() const {
+    TM_TRACE_SPAN("line of sight", "game");
+    sightDisk();   // Built once, before any worker can race for it
+
+    // Every cell is independent, so big maps are split across cores; the
+    // workers only read the board and write their own slice of the result
+    m_visibility.resize(cellCount());
+    quint64* out = m_visibility.data();
+    const int threads = cellCount() < 4096 ? 1 : qMax(1, QThread::idealThreadCount());
+    const int chunk = (cellCount() + threads - 1) / threads;
+    auto work = [this, out, chunk](int first) {
+        const int last = qMin(cellCount(), first + chunk);
+        for (int index = first; index < last; ++index) {
+            out[index] = visibilityOf(index);
+        }
+    };
+
+    QVector<QThread*> workers;
+    for (int i = 1; i < threads; ++i) {
+        QThread* worker = QThread::create(work, i * chunk);
+        worker->setObjectName(QString("sight %1").arg(i));
+        worker->start();
+        workers.append(worker);
+    }
+    work(0);
+    for (QThread* worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+quint64 HexBoard::visibilityOf(int index) const {
+    const SightDisk& disk = sightDisk();
+    const int row = m_rows[index];
+    const int col = m_cols[index];
+
+    auto clear = [&](const QVector<SightOffset>& crossed) {
+        for (const SightOffset& offset : crossed) {
+            const int cell = indexAt(row + offset.row, col + offset.col);
+            if (cell >= 0 && m_terrain[cell] == Rock) return false;
+        }
+        return true;
+    };
+
+    quint64 bits = 0;
+    for (int bit = 0; bit < disk.cells.size(); ++bit) {
+        if (indexAt(row + disk.cells[bit].row, col + disk.cells[bit].col) < 0) continue;
+        // A line running exactly along a hex edge sees past a rock on one side
+        if (clear(disk.between[0][bit]) || clear(disk.between[1][bit])) {
+            bits |= quint64(1) << bit;
+        }
+    }
+    return bits;
+}
+
+bool HexBoard::isVisible(int from, int to) const {
+    const int bit = sightDisk().bitFor(m_rows[to] - m_rows[from], m_cols[to] - m_cols[from]);
+    return bit >= 0 && (visibility()[from] >> bit) & 1;
+}
+
+void HexBoard::cellsInSight(int index, int radius, bool lineOfSight, QVector<int>& out) const {
+    out.clear();
+    const SightDisk& disk = sightDisk();
+    const int row = m_rows[index];
+    const int col = m_cols[index];
+    const quint64 visible = lineOfSight ? visibility()[index] : ~quint64(0);
+    for (int bit = 0; bit < disk.cells.size(); ++bit) {
+        const SightOffset& offset = disk.cells[bit];
+        if (offset.distance > radius) continue;
+        if (!((visible >> bit) & 1)) continue;
+        const int cell = indexAt(row + offset.row, col + offset.col);
+        if (cell >= 0) out.append(cell);
+    }
+}
@@ -0,0 +1,89 @@
+// HexBoard.h - Immutable map data: terrain, placement zones and adjacency
+#ifndef HEXBOARD_H
+#define HEXBOARD_H
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <mutex>
+
+// A parsed gridN.txt map. Nothing here changes once a board is built, so one
+// instance is shared (read-only) by the GUI, every match on a server thread,
+// and the load generator. Cells are addressed by index, in file order, which
+// is also the index GamePage gives its Cell items.
+class HexBoard {
+public:
+    // Same values as Cell::CellType
+    enum Terrain : quint8 {
+        Normal,
+        Water,
+        Rock,
+        Goal
+    };
+
+    static QSharedPointer<const HexBoard> fromFile(const QString& path, const QString& name);
+    static QSharedPointer<const HexBoard> fromText(const QString& text, const QString& name);
+
+    // Straight from cell data, for maps made in memory (see MapGenerator.h);
+    // cells keep their order as indices
+    struct CellSpec {
+        int row;
+        int col;
+        Terrain terrain;
+        int zone;
+    };
+    static QSharedPointer<const HexBoard> fromCells(const QVector<CellSpec>& cells, const QString& name);
+
+    QString name() const { return m_name; }
+    int cellCount() const { return m_rows.size(); }
+
+    int row(int index) const { return m_rows[index]; }
+    int col(int index) const { return m_cols[index]; }
+    Terrain terrain(int index) const { return Terrain(m_terrain[index]); }
+    int zone(int index) const { return m_zones[index]; }   // 0 = none, 1 = player 1, 2 = player 2
+    int indexAt(int row, int col) const;
+
+    // Neighbours of a cell, in the same order GamePage has always used
+    const int* neighborsBegin(int index) const { return m_adjacency.constData() + m_adjacencyStart[index]; }
+    const int* neighborsEnd(int index) const { return m_adjacency.constData() + m_adjacencyStart[index + 1]; }
+
+    const QVector<int>& placementZone(int playerIndex) const { return m_placementZones[playerIndex]; }
+    const QVector<int>& goalCells() const { return m_goalCells; }
+
+    // Line of sight: no Rock on the hex line between the two cells (the
+    // ends themselves never block). Computed per cell for every cell up to
+    // SightRange steps away, one bit each, the first time anything asks, so
+    // boards played without the rule never pay for it; farther cells are
+    // never visible.
+    static const int SightRange = 4;
+    bool isVisible(int from, int to) const;
+
+    // The cells up to radius (<= SightRange) steps from a cell, itself
+    // included; with lineOfSight, only those isVisible() from it. Fills out,
+    // which is cleared first so callers can reuse one buffer.
+    void cellsInSight(int index, int radius, bool lineOfSight, QVector<int>& out) const;
+
+private:
+    HexBoard() = default;
+    void addCell(int row, int col, Terrain terrain, int zone);
+    void buildAdjacency();
+    const QVector<quint64>& visibility() const;
+    void buildVisibility() const;
+    quint64 visibilityOf(int index) const;
+
+    QString m_name;
+    QVector<int> m_rows;
+    QVector<int> m_cols;
+    QVector<quint8> m_terrain;
+    QVector<quint8> m_zones;
+    QHash<quint64, int> m_indexByPosition;
+    QVector<int> m_adjacencyStart;   // cellCount() + 1 offsets into m_adjacency
+    QVector<int> m_adjacency;
+    QVector<int> m_placementZones[2];
+    QVector<int> m_goalCells;
+    mutable QVector<quint64> m_visibility;   // Bit k: the k-th cell of the sight disk around it
+    mutable std::once_flag m_visibilityBuilt;   // Boards are shared across threads
+};
+
+#endif // HEXBOARD_H
@@ -0,0 +1,178 @@
+// LoadClient.cpp - Implementation of LoadClient
+#include "LoadClient.h"
+#include "AgentRoster.h"
+#include "GameSnapshot.h"
+#include "MatchState.h"
+#include "NetworkSession.h"
+#include "TraceRecorder.h"
+#include <climits>
+
+LoadClient::LoadClient(int clientId, const QHash<QString, QSharedPointer<const HexBoard>>& boards,
+                       QObject* parent)
+    : QObject(parent), m_clientId(clientId), m_boards(boards)
+{
+    m_session = new NetworkSession(this);
+    connect(m_session, &NetworkSession::connected, this, [this]() {
+        m_session->sendHello(QString("bot-%1").arg(m_clientId));
+    });
+    connect(m_session, &NetworkSession::seatReceived, this, [this](int playerIndex) {
+        m_seat = playerIndex;
+    });
+    connect(m_session, &NetworkSession::snapshotReceived, this, &LoadClient::onSnapshot);
+    connect(m_session, &NetworkSession::deltaReceived, this, &LoadClient::onDelta);
+    connect(m_session, &NetworkSession::disconnected, this, &LoadClient::onDisconnected);
+    connect(m_session, &NetworkSession::errorOccurred, this, [this]() {
+        if (!m_session->isConnected()) finish(Dropped);
+    });
+}
+
+LoadClient::~LoadClient() {
+}
+
+void LoadClient::start(const QString& address, quint16 port) {
+    m_session->join(address, port);
+}
+
+void LoadClient::stopTimer() {
+    if (m_awaitingReply) {
+        m_latencies.append(m_requestTimer.nsecsElapsed() / 1000);
+        m_awaitingReply = false;
+    }
+}
+
+void LoadClient::onSnapshot(const QByteArray& blob) {
+    if (m_outcome != Playing) return;
+
+    GameSnapshot snapshot(blob);
+    QSharedPointer<const HexBoard> board = m_boards.value(snapshot.mapName());
+    if (!snapshot.isValid() || !board) {
+        finish(Dropped);
+        return;
+    }
+
+    if (!m_state || m_state->board().name() != board->name()) {
+        m_state.reset(new MatchState(board));
+        m_state->setThreatTracking(true);
+    }
+    if (!m_state->loadSnapshot(snapshot)) {
+        finish(Dropped);
+        return;
+    }
+    stopTimer();
+
+    if (m_state->isBattle()) {
+        act();
+    } else {
+        placeNextAgent();
+    }
+}
+
+void LoadClient::onDelta(const GameDelta& delta) {
+    if (m_outcome != Playing || !m_state) return;
+
+    m_state->applyDelta(delta);
+    stopTimer();
+    act();
+}
+
+void LoadClient::onDisconnected() {
+    if (m_state && m_state->isBattle() && m_state->isGameOver()) {
+        finish(GameOver);
+    } else {
+        finish(Dropped);
+    }
+}
+
+void LoadClient::placeNextAgent() {
+    if (m_awaitingReply || m_seat < 0) return;
+
+    const int placed = m_state->agentCount(m_seat);
+    if (placed >= 3) return;
+
+    // Three consecutive roster entries per bot: distinct names, varied types
+    const QVector<AgentDef>& roster = AgentRoster::all();
+    const AgentDef& def = roster[(m_clientId * 3 + placed) % roster.size()];
+
+    for (int cell : m_state->validPlacementCells(m_seat)) {
+        if (GameRules::canPlaceOn(def.type, m_state->board().terrain(cell))) {
+            m_requestTimer.start();
+            m_awaitingReply = true;
+            m_session->sendPlace(def.name, cell);
+            return;
+        }
+    }
+}
+
+void LoadClient::act() {
+    TM_TRACE_SPAN("bot thinking", "ai");
+    if (m_state->isGameOver()) {
+        finish(GameOver);
+        return;
+    }
+    if (m_awaitingReply || m_state->currentPlayer() != m_seat) return;
+
+    const QVector<MatchAgent>& agents = m_state->agents();
+
+    // Attack whenever anything is in range. Under fog of war the bot only
+    // knows about the enemies its own agents can see.
+    for (int id = 0; id < agents.size(); ++id) {
+        if (agents[id].owner != m_seat || !agents[id].isAlive()) continue;
+        for (int target = 0; target < agents.size(); ++target) {
+            if (m_state->isVisibleTo(m_seat, agents[target].cell) && m_state->canAttack(id, target)) {
+                m_requestTimer.start();
+                m_awaitingReply = true;
+                m_session->sendAction(agents[id].cell, agents[target].cell);
+                return;
+            }
+        }
+    }
+
+    // Otherwise take the move that ends the fewest moves away from any
+    // visible enemy, or from the enemy's placement zone while none is in
+    // sight (one distance field for all agents); of equally close
+    // cells, the one the enemy can deal the least damage to. The threat map
+    // knows about hidden enemies too, so it is left alone under fog of war.
+    QVector<int> goals;
+    for (const MatchAgent& enemy : agents) {
+        if (enemy.owner != m_seat && enemy.isAlive() && m_state->isVisibleTo(m_seat, enemy.cell)) {
+            goals.append(enemy.cell);
+        }
+    }
+    if (goals.isEmpty()) {
+        goals = m_state->board().placementZone(1 - m_seat);
+    }
+    m_state->distancesTo(goals, m_goalDistances);
+
+    int bestFrom = -1;
+    int bestTo = -1;
+    int bestDistance = INT_MAX;
+    int bestThreat = INT_MAX;
+    for (int id = 0; id < agents.size(); ++id) {
+        if (agents[id].owner != m_seat || !agents[id].isAlive()) continue;
+        for (int cell : m_state->reachableCells(id)) {
+            const int threat = m_state->fogOfWar() ? 0 : m_state->threats().threatDamage(1 - m_seat, cell);
+            const int distance = m_goalDistances.at(cell, agents[id].type);
+            if (distance < bestDistance || (distance == bestDistance && threat < bestThreat)) {
+                bestDistance = distance;
+                bestThreat = threat;
+                bestFrom = agents[id].cell;
+                bestTo = cell;
+            }
+        }
+    }
+
+    if (bestFrom < 0) {
+        finish(Stalled);
+        return;
+    }
+    m_requestTimer.start();
+    m_awaitingReply = true;
+    m_session->sendAction(bestFrom, bestTo);
+}
+
+void LoadClient::finish(Outcome outcome) {
+    if (m_outcome != Playing) return;
+    m_outcome = outcome;
+    m_session->closeGracefully();
+    emit finished(this);
+}
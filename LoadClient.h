@@ -0,0 +1,66 @@
+// LoadClient.h - Simulated player used by the tm_loadgen load generator
+#ifndef LOADCLIENT_H
+#define LOADCLIENT_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QVector>
+#include "DistanceField.h"
+#include "GameHistory.h"
+#include "HexBoard.h"
+
+class MatchState;
+class NetworkSession;
+
+// Speaks the normal client protocol and plays a simple greedy game (attack
+// when possible, otherwise close in on the nearest enemy), timing every
+// request from send to the server's answer.
+class LoadClient : public QObject {
+    Q_OBJECT
+
+public:
+    enum Outcome {
+        Playing,
+        GameOver,       // The match reached a winner
+        Stalled,        // No legal action left (the rules have no "pass")
+        Dropped         // Disconnected before the match was decided
+    };
+
+    LoadClient(int clientId, const QHash<QString, QSharedPointer<const HexBoard>>& boards,
+               QObject* parent = nullptr);
+    ~LoadClient();
+
+    void start(const QString& address, quint16 port);
+
+    Outcome outcome() const { return m_outcome; }
+    const QVector<qint64>& latencies() const { return m_latencies; }   // Microseconds
+
+signals:
+    void finished(LoadClient* client);
+
+private:
+    void onSnapshot(const QByteArray& blob);
+    void onDelta(const GameDelta& delta);
+    void onDisconnected();
+    void stopTimer();
+    void placeNextAgent();
+    void act();
+    void finish(Outcome outcome);
+
+    int m_clientId;
+    QHash<QString, QSharedPointer<const HexBoard>> m_boards;
+    NetworkSession* m_session = nullptr;
+    QScopedPointer<MatchState> m_state;
+    int m_seat = -1;
+    DistanceField m_goalDistances;   // Reused by every act()
+
+    QElapsedTimer m_requestTimer;
+    bool m_awaitingReply = false;
+    QVector<qint64> m_latencies;
+    Outcome m_outcome = Playing;
+};
+
+#endif // LOADCLIENT_H
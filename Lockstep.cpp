@@ -0,0 +1,23 @@
+// Lockstep.cpp - Implementation of LockstepRandom and StateChecksum
+#include "Lockstep.h"
+
+quint32 LockstepRandom::next() {
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state;
+}
+
+int LockstepRandom::bounded(int bound) {
+    if (bound <= 0) return 0;
+    // Multiply-shift instead of modulo: no bias toward low values
+    return int((quint64(next()) * quint32(bound)) >> 32);
+}
+
+void StateChecksum::add(qint32 value) {
+    const quint32 bits = quint32(value);
+    for (int shift = 0; shift < 32; shift += 8) {
+        m_hash ^= (bits >> shift) & 0xFFu;
+        m_hash *= 16777619u;
+    }
+}
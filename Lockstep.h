@@ -0,0 +1,37 @@
+// Lockstep.h - Deterministic random numbers and state checksums for lockstep play
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <QtGlobal>
+
+// Every random choice the rules make goes through this generator, so two
+// peers seeded alike stay in step by exchanging nothing but actions.
+// xorshift32: fixed algorithm, no platform or library dependence.
+class LockstepRandom {
+public:
+    explicit LockstepRandom(quint32 seed = 1) { setSeed(seed); }
+
+    void setSeed(quint32 seed) { m_state = seed ? seed : 0x9E3779B9u; }
+    quint32 state() const { return m_state; }
+
+    quint32 next();
+    int bounded(int bound);   // Uniform in [0, bound)
+
+private:
+    quint32 m_state;
+};
+
+// FNV-1a over 32-bit values. Seed it with the previous checksum to get a
+// rolling checksum that covers the whole action history.
+class StateChecksum {
+public:
+    explicit StateChecksum(quint32 previous = 0) : m_hash(2166136261u ^ previous) {}
+
+    void add(qint32 value);
+    quint32 value() const { return m_hash; }
+
+private:
+    quint32 m_hash;
+};
+
+#endif // LOCKSTEP_H
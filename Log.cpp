@@ -0,0 +1,128 @@
+// Log.cpp - Ring buffer and flushing for Log
+#include "Log.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTimer>
+#include <atomic>
+
+namespace Log {
+
+namespace {
+
+// Bounded multi-producer queue (Vyukov): each slot carries a sequence number
+// telling producers and the consumer whose turn it is, so producers never
+// take a lock. Flushing is serialised by a mutex, producers never wait on it.
+const quint64 Capacity = 8192;   // Power of two
+
+struct Slot {
+    std::atomic<quint64> sequence;
+    Record record;
+};
+
+Slot* slots() {
+    static Slot* buffer = []() {
+        Slot* created = new Slot[Capacity];
+        for (quint64 i = 0; i < Capacity; ++i) {
+            created[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        return created;
+    }();
+    return buffer;
+}
+
+std::atomic<quint64> g_enqueuePosition{0};
+quint64 g_dequeuePosition = 0;       // Guarded by flushMutex()
+std::atomic<quint64> g_dropped{0};
+
+QMutex& flushMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+QString format(const Record& record) {
+    QString text = QString::fromUtf8(record.format);
+    for (int i = 0; i < record.argCount; ++i) {
+        const Arg& arg = record.args[i];
+        switch (arg.type) {
+        case Arg::Int: text = text.arg(arg.i); break;
+        case Arg::UInt: text = text.arg(arg.u); break;
+        case Arg::Double: text = text.arg(arg.d); break;
+        case Arg::Bool: text = text.arg(QLatin1String(arg.b ? "true" : "false")); break;
+        case Arg::CString: text = text.arg(QString::fromUtf8(arg.s)); break;
+        case Arg::String: text = text.arg(arg.string); break;
+        }
+    }
+    return text;
+}
+
+void print(Level level, const QString& text) {
+    switch (level) {
+    case Trace:
+    case Debug: qDebug().noquote() << text; break;
+    case Info: qInfo().noquote() << text; break;
+    case Warning: qWarning().noquote() << text; break;
+    case Error: qCritical().noquote() << text; break;
+    }
+}
+
+}
+
+Record* claim(quint64& ticket) {
+    Slot* buffer = slots();
+    quint64 position = g_enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = buffer[position & (Capacity - 1)];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        const qint64 difference = qint64(sequence) - qint64(position);
+        if (difference == 0) {
+            if (g_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                ticket = position;
+                return &slot.record;
+            }
+        } else if (difference < 0) {
+            // Nobody flushed for a whole buffer's worth of messages
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            position = g_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void publish(quint64 ticket) {
+    slots()[ticket & (Capacity - 1)].sequence.store(ticket + 1, std::memory_order_release);
+}
+
+void flush() {
+    QMutexLocker locker(&flushMutex());
+    Slot* buffer = slots();
+
+    for (;;) {
+        Slot& slot = buffer[g_dequeuePosition & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != g_dequeuePosition + 1) break;
+
+        print(slot.record.level, format(slot.record));
+        for (int i = 0; i < slot.record.argCount; ++i) {
+            slot.record.args[i].string = QString();
+        }
+        slot.sequence.store(g_dequeuePosition + Capacity, std::memory_order_release);
+        ++g_dequeuePosition;
+    }
+
+    if (const quint64 dropped = g_dropped.exchange(0, std::memory_order_relaxed)) {
+        qWarning().noquote() << QString("Log buffer full, %1 messages dropped").arg(dropped);
+    }
+}
+
+void installFlushTimer(int intervalMs) {
+    QCoreApplication* app = QCoreApplication::instance();
+    if (!app) return;
+
+    QTimer* timer = new QTimer(app);
+    QObject::connect(timer, &QTimer::timeout, &flush);
+    timer->start(intervalMs);
+    qAddPostRoutine(&flush);
+}
+
+}
@@ -0,0 +1,118 @@
+// Log.h - Structured logging with compile-time level filtering
+#ifndef LOG_H
+#define LOG_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Usage:
+//   TM_LOG_DEBUG("canMoveTo: %1 with %2 moves", m_name, m_remainingMoves);
+//
+// Levels below TM_LOG_LEVEL are removed at compile time: the arguments are
+// never evaluated and no code is emitted. By default that keeps Debug and
+// up in debug builds and Info and up in release builds.
+//
+// Enabled calls do no formatting. They copy the format string pointer and
+// the raw arguments into a fixed-size lock-free ring buffer (any thread);
+// Log::flush() formats and prints them later through the Qt message handler.
+// The format must be a string literal, as must any const char* argument.
+namespace Log {
+
+enum Level {
+    Trace = 0,
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+struct Arg {
+    enum Type : quint8 {
+        Int,
+        UInt,
+        Double,
+        Bool,
+        CString,
+        String
+    };
+
+    Type type = Int;
+    union {
+        qint64 i;
+        quint64 u;
+        double d;
+        bool b;
+        const char* s;
+    };
+    QString string;   // Shared, not copied: only a reference count bump
+};
+
+struct Record {
+    static const int MaxArgs = 6;
+
+    Level level = Debug;
+    const char* format = nullptr;
+    int argCount = 0;
+    Arg args[MaxArgs];
+
+    void append(int value) { appendInt(value); }
+    void append(long value) { appendInt(value); }
+    void append(long long value) { appendInt(value); }
+    void append(unsigned value) { appendUInt(value); }
+    void append(unsigned long value) { appendUInt(value); }
+    void append(unsigned long long value) { appendUInt(value); }
+    void append(double value) { Arg& arg = args[argCount++]; arg.type = Arg::Double; arg.d = value; }
+    void append(bool value) { Arg& arg = args[argCount++]; arg.type = Arg::Bool; arg.b = value; }
+    void append(const char* value) { Arg& arg = args[argCount++]; arg.type = Arg::CString; arg.s = value; }
+    void append(const QString& value) { Arg& arg = args[argCount++]; arg.type = Arg::String; arg.string = value; }
+
+private:
+    void appendInt(qint64 value) { Arg& arg = args[argCount++]; arg.type = Arg::Int; arg.i = value; }
+    void appendUInt(quint64 value) { Arg& arg = args[argCount++]; arg.type = Arg::UInt; arg.u = value; }
+};
+
+// Ring buffer access; use the TM_LOG_* macros rather than these
+Record* claim(quint64& ticket);     // nullptr when the buffer is full (counted as dropped)
+void publish(quint64 ticket);
+
+template <typename... Args>
+void write(Level level, const char* format, const Args&... args) {
+    static_assert(sizeof...(Args) <= Record::MaxArgs, "Too many log arguments");
+
+    quint64 ticket;
+    Record* record = claim(ticket);
+    if (!record) return;
+
+    record->level = level;
+    record->format = format;
+    record->argCount = 0;
+    (record->append(args), ...);
+    publish(ticket);
+}
+
+// Formats and prints everything buffered so far. Safe from any thread.
+void flush();
+
+// Flushes periodically on the application's event loop and once at exit
+void installFlushTimer(int intervalMs = 250);
+
+}
+
+#ifndef TM_LOG_LEVEL
+#  ifdef QT_NO_DEBUG
+#    define TM_LOG_LEVEL 2   // Info
+#  else
+#    define TM_LOG_LEVEL 1   // Debug
+#  endif
+#endif
+
+#define TM_LOG(level, ...) \
+    do { if constexpr (Log::level >= TM_LOG_LEVEL) Log::write(Log::level, __VA_ARGS__); } while (0)
+
+#define TM_LOG_TRACE(...) TM_LOG(Trace, __VA_ARGS__)
+#define TM_LOG_DEBUG(...) TM_LOG(Debug, __VA_ARGS__)
+#define TM_LOG_INFO(...) TM_LOG(Info, __VA_ARGS__)
+#define TM_LOG_WARNING(...) TM_LOG(Warning, __VA_ARGS__)
+#define TM_LOG_ERROR(...) TM_LOG(Error, __VA_ARGS__)
+
+#endif // LOG_H
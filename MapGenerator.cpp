@@ -0,0 +1,179 @@
+// MapGenerator.cpp - Implementation of MapGenerator
+#include "MapGenerator.h"
+#include <QRegularExpression>
+#include <cmath>
+#include "Lockstep.h"
+#include "TraceRecorder.h"
+
+namespace {
+
+// A pseudo-random value in [0, 1) for each integer lattice point
+double latticeValue(int x, int y, quint32 seed) {
+    quint32 h = seed * 0x9e3779b1u ^ quint32(x) * 0x85ebca77u ^ quint32(y) * 0xc2b2ae3du;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return (h & 0xffffff) / double(0x1000000);
+}
+
+// Value noise: lattice values blended with a smoothstep, so neighbouring
+// hexes get similar heights
+double valueNoise(double x, double y, quint32 seed) {
+    const double fx = std::floor(x);
+    const double fy = std::floor(y);
+    const int x0 = int(fx);
+    const int y0 = int(fy);
+    const double tx = x - fx;
+    const double ty = y - fy;
+    const double sx = tx * tx * (3 - 2 * tx);
+    const double sy = ty * ty * (3 - 2 * ty);
+
+    const double top = latticeValue(x0, y0, seed) + sx * (latticeValue(x0 + 1, y0, seed) - latticeValue(x0, y0, seed));
+    const double bottom = latticeValue(x0, y0 + 1, seed)
+                          + sx * (latticeValue(x0 + 1, y0 + 1, seed) - latticeValue(x0, y0 + 1, seed));
+    return top + sy * (bottom - top);
+}
+
+// Three octaves: features about eight, four and two hexes across
+double elevation(double x, double y, quint32 seed) {
+    return 0.57 * valueNoise(x / 8, y / 8, seed)
+           + 0.29 * valueNoise(x / 4, y / 4, seed + 1)
+           + 0.14 * valueNoise(x / 2, y / 2, seed + 2);
+}
+
+const int HistogramBins = 1024;
+
+// The height below which about fraction of the values lie
+double threshold(const QVector<int>& histogram, int total, double fraction) {
+    const int wanted = int(total * fraction);
+    int seen = 0;
+    for (int bin = 0; bin < HistogramBins; ++bin) {
+        if (seen >= wanted) return double(bin) / HistogramBins;
+        seen += histogram[bin];
+    }
+    return 1.0;
+}
+
+}
+
+MapGenerator::MapGenerator(const Options& options) : m_options(options) {
+    generate();
+}
+
+void MapGenerator::generate() {
+    TM_TRACE_SPAN("generate map", "game");
+
+    // About square in hexes; an even number of lines gives every cell a
+    // twin half a turn around the centre
+    m_pairs = qMax(2, int(std::sqrt(qMax(1, m_options.targetCells) / 4.0)));
+    m_lines = qMax(2, (m_options.targetCells + m_pairs - 1) / m_pairs);
+    m_lines += m_lines & 1;
+    const int total = m_pairs * m_lines;
+    const int half = total / 2;
+    const int zoneColumns = qBound(1, m_options.zoneColumns, m_pairs / 2);
+
+    // Cell i and cell total - 1 - i are twins: only the first half is
+    // generated, the second half copies it
+    m_cells.resize(total);
+    QVector<double> heights(half);
+    QVector<int> histogram(HistogramBins, 0);
+    int open = 0;
+    for (int i = 0; i < half; ++i) {
+        const int line = i / m_pairs;
+        const int pair = i % m_pairs;
+        HexBoard::CellSpec& cell = m_cells[i];
+        cell.row = line + 2;                    // As fromText numbers them
+        cell.col = 2 * pair + (line & 1);
+        cell.terrain = HexBoard::Normal;
+        cell.zone = pair < zoneColumns ? 1 : (pair >= m_pairs - zoneColumns ? 2 : 0);
+
+        if (cell.zone == 0) {
+            heights[i] = elevation(cell.col * 0.5, cell.row * 0.866, m_options.seed);
+            ++histogram[qBound(0, int(heights[i] * HistogramBins), HistogramBins - 1)];
+            ++open;
+        }
+    }
+
+    const double waterBelow = threshold(histogram, open, m_options.waterPercent / 100.0);
+    const double rockAbove = threshold(histogram, open, 1.0 - m_options.rockPercent / 100.0);
+    for (int i = 0; i < half; ++i) {
+        if (m_cells[i].zone != 0) continue;
+        if (heights[i] < waterBelow) m_cells[i].terrain = HexBoard::Water;
+        else if (heights[i] >= rockAbove && m_options.rockPercent > 0) m_cells[i].terrain = HexBoard::Rock;
+    }
+
+    // Goals on open cells of the first half, each with its twin
+    LockstepRandom random(m_options.seed);
+    const int goalPairs = (qMax(0, m_options.goalCount) + 1) / 2;
+    for (int placed = 0, attempts = 0; placed < goalPairs && attempts < 64 * goalPairs; ++attempts) {
+        const int i = int(random.bounded(half));
+        if (m_cells[i].zone == 0 && m_cells[i].terrain == HexBoard::Normal) {
+            m_cells[i].terrain = HexBoard::Goal;
+            ++placed;
+        }
+    }
+
+    for (int i = half; i < total; ++i) {
+        const HexBoard::CellSpec& twin = m_cells[total - 1 - i];
+        HexBoard::CellSpec& cell = m_cells[i];
+        const int line = i / m_pairs;
+        cell.row = line + 2;
+        cell.col = 2 * (i % m_pairs) + (line & 1);
+        cell.terrain = twin.terrain;
+        cell.zone = twin.zone == 0 ? 0 : 3 - twin.zone;
+    }
+}
+
+QString MapGenerator::toText() const {
+    // Each hex is "/c \" over "\__/"; consecutive lines interleave, so every
+    // text line shows one line's tops next to the previous line's bottoms
+    QString text;
+    text.reserve((m_lines + 2) * (6 * m_pairs + 2));
+    for (int pair = 0; pair < m_pairs; ++pair) text += QLatin1String(" __   ");
+    text += '\n';
+
+    for (int line = 0; line < m_lines; ++line) {
+        for (int pair = 0; pair < m_pairs; ++pair) {
+            const HexBoard::CellSpec& cell = m_cells[line * m_pairs + pair];
+            QChar code = ' ';
+            if (cell.zone == 1) code = '1';
+            else if (cell.zone == 2) code = '2';
+            else if (cell.terrain == HexBoard::Water) code = '~';
+            else if (cell.terrain == HexBoard::Rock) code = '#';
+            else if (cell.terrain == HexBoard::Goal) code = '*';
+
+            if (line % 2 == 0) {
+                text += '/';
+                text += code;
+                text += QLatin1String(" \\__");
+            } else {
+                text += QLatin1String("\\__/");
+                text += code;
+                text += ' ';
+            }
+        }
+        text += QLatin1String(line % 2 == 0 ? "/\n" : "\\\n");
+    }
+
+    // Closing border: parsed as the final line and never turned into cells
+    for (int pair = 0; pair < m_pairs; ++pair) text += QLatin1String("\\__/  ");
+    text += '\n';
+    return text;
+}
+
+QSharedPointer<const HexBoard> MapGenerator::toBoard(const QString& name) const {
+    return HexBoard::fromCells(m_cells, name);
+}
+
+QSharedPointer<const HexBoard> MapGenerator::fromName(const QString& name) {
+    static const QRegularExpression pattern("^gen-(\\d+)(-(\\d+))?$");
+    const QRegularExpressionMatch match = pattern.match(name);
+    if (!match.hasMatch()) return QSharedPointer<const HexBoard>();
+
+    Options options;
+    options.targetCells = qBound(4, match.captured(1).toInt(), 4000000);
+    options.seed = match.captured(3).isEmpty() ? quint32(options.targetCells) : match.captured(3).toUInt();
+    return MapGenerator(options).toBoard(name);
+}
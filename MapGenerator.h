@@ -0,0 +1,48 @@
+// MapGenerator.h - Seeded procedural maps of any size
+#ifndef MAPGENERATOR_H
+#define MAPGENERATOR_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "HexBoard.h"
+
+// Lays out a rectangle of hexes the way gridN.txt does, about square in
+// hexes, and gives it terrain from a smooth noise field: the lowest ground
+// becomes Water, the highest Rock, so both come in lakes and ridges rather
+// than single cells. The map is point symmetric (turned half a turn it is
+// the same), so player 1's zone on the left edge and player 2's on the
+// right face the same board. Same options, same map, on every machine.
+//
+// Generated maps are named "gen-<cells>" or "gen-<cells>-<seed>"; fromName()
+// turns such a name back into the board, so a server and its clients only
+// need to agree on the name.
+class MapGenerator {
+public:
+    struct Options {
+        int targetCells = 1000;     // Rounded to whole text lines
+        quint32 seed = 1;
+        int waterPercent = 10;      // Of the cells outside the zones
+        int rockPercent = 5;
+        int goalCount = 0;          // Placed in mirrored pairs, so rounded up to even
+        int zoneColumns = 1;        // Hexes per line in each placement zone
+    };
+
+    explicit MapGenerator(const Options& options);
+
+    const QVector<HexBoard::CellSpec>& cells() const { return m_cells; }
+    QString toText() const;   // The gridN.txt format
+    QSharedPointer<const HexBoard> toBoard(const QString& name) const;
+
+    static QSharedPointer<const HexBoard> fromName(const QString& name);   // Null if not a generated name
+
+private:
+    void generate();
+
+    Options m_options;
+    int m_pairs = 0;                // Hexes per text line
+    int m_lines = 0;                // Text lines of hexes, always even
+    QVector<HexBoard::CellSpec> m_cells;   // Line by line, left to right
+};
+
+#endif // MAPGENERATOR_H
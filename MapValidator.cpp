@@ -0,0 +1,168 @@
+// MapValidator.cpp - Implementation of MapValidator
+#include "MapValidator.h"
+#include "Log.h"
+#include "MoveCosts.h"
+#include "TraceRecorder.h"
+
+namespace {
+
+const char* const TypeNames[] = {"WaterWalking", "Grounded", "Flying", "Floating"};   // AgentType order
+
+const quint8 Counted = 2;   // m_passable value of a choke point already counted
+
+}
+
+bool MapValidator::Report::playable() const {
+    for (const TypeReport& report : types) {
+        if (!report.zonesConnected) return false;
+    }
+    return true;
+}
+
+bool MapValidator::logProblems(const HexBoard& board) {
+    MapValidator validator;
+    const Report report = validator.check(board);
+    for (int type = 0; type < TypeCount; ++type) {
+        const TypeReport& typeReport = report.types[type];
+        if (!typeReport.zonesConnected) {
+            TM_LOG_WARNING("Map %1: %2 agents cannot get from one placement zone to the other",
+                           board.name(), QLatin1String(TypeNames[type]));
+        } else {
+            TM_LOG_DEBUG("Map %1: %2 agents have %3 regions, %4 choke points, %5 stranded zone cells",
+                         board.name(), QLatin1String(TypeNames[type]), typeReport.regions,
+                         typeReport.chokePoints, typeReport.strandedZoneCells);
+        }
+    }
+    return report.playable();
+}
+
+int MapValidator::find(int cell) {
+    while (m_parent[cell] != cell) {
+        m_parent[cell] = m_parent[m_parent[cell]];
+        cell = m_parent[cell];
+    }
+    return cell;
+}
+
+void MapValidator::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (m_size[a] < m_size[b]) qSwap(a, b);
+    m_parent[b] = a;
+    m_size[a] += m_size[b];
+}
+
+MapValidator::Report MapValidator::check(const HexBoard& board) {
+    TM_TRACE_SPAN("validate map", "game");
+    const int cells = board.cellCount();
+    const MoveCosts& costs = MoveCosts::standard();
+    Report report;
+
+    for (int type = 0; type < TypeCount; ++type) {
+        TypeReport& typeReport = report.types[type];
+        m_passable.resize(cells);
+        m_parent.resize(cells);
+        m_size.fill(1, cells);
+        for (int cell = 0; cell < cells; ++cell) {
+            m_passable[cell] = costs.canPass(AgentType(type), board.terrain(cell));
+            m_parent[cell] = cell;
+        }
+
+        // Each edge once, from its lower end
+        for (int cell = 0; cell < cells; ++cell) {
+            if (!m_passable[cell]) continue;
+            ++typeReport.passableCells;
+            for (const int* it = board.neighborsBegin(cell); it != board.neighborsEnd(cell); ++it) {
+                if (*it > cell && m_passable[*it]) unite(cell, *it);
+            }
+        }
+
+        // Per region root: bit 0 if it holds a zone 1 cell, bit 1 for zone 2
+        m_reachesTarget.fill(0, cells + 2);
+        for (int cell = 0; cell < cells; ++cell) {
+            if (!m_passable[cell]) continue;
+            const int root = find(cell);
+            if (root == cell) ++typeReport.regions;
+            if (board.zone(cell) != 0) m_reachesTarget[root] |= quint8(board.zone(cell));
+        }
+        for (int cell = 0; cell < cells; ++cell) {
+            if (!m_passable[cell] || board.zone(cell) == 0) continue;
+            const quint8 zones = m_reachesTarget[find(cell)];
+            if (zones == 3) typeReport.zonesConnected = true;
+            else ++typeReport.strandedZoneCells;
+        }
+
+        if (typeReport.zonesConnected) typeReport.chokePoints = countChokePoints(board);
+    }
+    return report;
+}
+
+int MapValidator::countChokePoints(const HexBoard& board) {
+    const int cells = board.cellCount();
+    const int source = cells;       // Joined to every passable zone 1 cell
+    const int target = cells + 1;   // Joined to every passable zone 2 cell
+    m_order.fill(0, cells + 2);
+    m_low.resize(cells + 2);
+    m_next.fill(0, cells + 2);
+    m_reachesTarget.fill(0, cells + 2);
+    m_reachesTarget[target] = 1;
+    m_stack.clear();
+
+    // The k-th neighbour of a vertex in the graph with the two virtual cells,
+    // skipping impassable cells; -1 once there are no more
+    auto nextNeighbor = [&](int vertex) -> int {
+        if (vertex >= cells) {
+            const QVector<int>& zone = board.placementZone(vertex - cells);
+            while (m_next[vertex] < zone.size()) {
+                const int cell = zone[m_next[vertex]++];
+                if (m_passable[cell]) return cell;
+            }
+            return -1;
+        }
+        const int* begin = board.neighborsBegin(vertex);
+        const int degree = int(board.neighborsEnd(vertex) - begin);
+        while (m_next[vertex] < degree) {
+            const int cell = begin[m_next[vertex]++];
+            if (m_passable[cell]) return cell;
+        }
+        if (m_next[vertex] == degree) {
+            ++m_next[vertex];
+            if (board.zone(vertex) == 1) return source;
+            if (board.zone(vertex) == 2) return target;
+        }
+        return -1;
+    };
+
+    // Depth-first from source. A vertex p cuts target off from source when
+    // some child's subtree holds target and has no edge climbing above p.
+    int discovered = 1;
+    int chokePoints = 0;
+    m_order[source] = m_low[source] = discovered;
+    m_stack.append(source);
+    while (!m_stack.isEmpty()) {
+        const int vertex = m_stack.last();
+        const int parent = m_stack.size() > 1 ? m_stack[m_stack.size() - 2] : -1;
+        const int neighbor = nextNeighbor(vertex);
+        if (neighbor >= 0) {
+            if (m_order[neighbor] == 0) {
+                m_order[neighbor] = m_low[neighbor] = ++discovered;
+                m_stack.append(neighbor);
+            } else if (neighbor != parent) {
+                m_low[vertex] = qMin(m_low[vertex], m_order[neighbor]);
+            }
+            continue;
+        }
+
+        m_stack.removeLast();
+        if (parent < 0) continue;
+        m_low[parent] = qMin(m_low[parent], m_low[vertex]);
+        m_reachesTarget[parent] |= m_reachesTarget[vertex];
+        if (parent < cells && board.zone(parent) == 0 && m_passable[parent] != Counted && m_reachesTarget[vertex]
+            && m_low[vertex] >= m_order[parent]) {
+            m_passable[parent] = Counted;
+            ++chokePoints;
+        }
+    }
+    return chokePoints;
+}
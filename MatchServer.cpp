@@ -0,0 +1,213 @@
+// MatchServer.cpp - Implementation of MatchShard and MatchServer
+#include "MatchServer.h"
+#include "AgentRoster.h"
+#include "GameSnapshot.h"
+#include "NetworkSession.h"
+#include <QThread>
+#include <QDebug>
+
+MatchShard::MatchShard(int shardId, const QVector<QSharedPointer<const HexBoard>>& boards, int rules,
+                       QObject* parent)
+    : QObject(parent), m_shardId(shardId), m_boards(boards), m_rules(rules)
+{
+}
+
+MatchShard::~MatchShard() {
+    qDeleteAll(m_matches);
+    qDeleteAll(m_seats);
+}
+
+void MatchShard::addConnection(qintptr socketDescriptor) {
+    Seat* seat = new Seat();
+    seat->session = new NetworkSession(this);
+    if (!seat->session->adoptDescriptor(socketDescriptor)) {
+        delete seat->session;
+        delete seat;
+        return;
+    }
+    m_seats.append(seat);
+
+    NetworkSession* session = seat->session;
+    connect(session, &NetworkSession::helloReceived, this, [this, seat](const QString& name) {
+        onHello(seat, name);
+    });
+    connect(session, &NetworkSession::placeReceived, this, [this, seat](const QString& cardName, int cellIndex) {
+        onPlace(seat, cardName, cellIndex);
+    });
+    connect(session, &NetworkSession::actionReceived, this, [this, seat](int fromCell, int toCell) {
+        onAction(seat, fromCell, toCell);
+    });
+    connect(session, &NetworkSession::disconnected, this, [this, seat]() {
+        onDisconnected(seat);
+    });
+}
+
+void MatchShard::onHello(Seat* seat, const QString& name) {
+    if (seat->match || seat == m_waiting) return;
+
+    seat->name = name;
+    if (m_waiting) {
+        Seat* opponent = m_waiting;
+        m_waiting = nullptr;
+        startMatch(opponent, seat);
+    } else {
+        m_waiting = seat;
+    }
+}
+
+void MatchShard::startMatch(Seat* first, Seat* second) {
+    const quint32 matchId = m_nextMatchId++;
+    QSharedPointer<const HexBoard> board = m_boards[int(matchId % quint32(m_boards.size()))];
+
+    Match* match = new Match(board, (quint32(m_shardId) << 20) ^ matchId);
+    match->state.setLineOfSight(m_rules & GameSnapshot::LineOfSight);
+    match->state.setFogOfWar(m_rules & GameSnapshot::Fog);
+    match->seats[0] = first;
+    match->seats[1] = second;
+    m_matches.append(match);
+    m_activeMatches.fetchAndAddRelaxed(1);
+
+    for (int player = 0; player < 2; ++player) {
+        Seat* seat = match->seats[player];
+        seat->match = match;
+        seat->player = player;
+        seat->session->sendSeat(player);
+        seat->session->sendWelcome(match->seats[1 - player]->name);
+    }
+    broadcastSnapshot(match);
+}
+
+void MatchShard::onPlace(Seat* seat, const QString& cardName, int cellIndex) {
+    Match* match = seat->match;
+    if (!match || match->finished) return;
+
+    MatchState& state = match->state;
+    const AgentDef* def = AgentRoster::find(cardName);
+
+    // One card of each kind per player, three agents each
+    bool duplicate = false;
+    for (const MatchAgent& agent : state.agents()) {
+        if (agent.owner == seat->player && agent.name == cardName) duplicate = true;
+    }
+
+    if (def && !duplicate && !state.isBattle() && state.agentCount(seat->player) < 3) {
+        state.placeAgent(seat->player, *def, cellIndex);
+    }
+
+    if (!state.isBattle() && state.agentCount(0) == 3 && state.agentCount(1) == 3) {
+        state.startBattle();
+    }
+
+    // Rejected or not, both sides get the authoritative state
+    broadcastSnapshot(match);
+}
+
+void MatchShard::onAction(Seat* seat, int fromCell, int toCell) {
+    Match* match = seat->match;
+    if (!match || match->finished) return;
+
+    MatchState& state = match->state;
+    GameDelta delta;
+    if (state.currentPlayer() != seat->player || !state.performAction(fromCell, toCell, &delta)) {
+        // Resync the client that sent something invalid
+        seat->session->sendSnapshot(state.toSnapshot());
+        return;
+    }
+
+    m_actionsApplied.fetchAndAddRelaxed(1);
+    ++match->actions;
+    for (Seat* player : match->seats) {
+        if (player) player->session->sendDelta(delta);
+    }
+
+    if (state.isGameOver() || match->actions >= MaxActionsPerMatch) {
+        finishMatch(match);
+    }
+}
+
+void MatchShard::finishMatch(Match* match) {
+    if (match->finished) return;
+    match->finished = true;
+    m_activeMatches.fetchAndSubRelaxed(1);
+    m_completedMatches.fetchAndAddRelaxed(1);
+
+    // Let the last delta go out, then hang up; cleanup happens on disconnect
+    for (Seat* seat : match->seats) {
+        if (seat) seat->session->closeGracefully();
+    }
+}
+
+void MatchShard::onDisconnected(Seat* seat) {
+    if (m_waiting == seat) {
+        m_waiting = nullptr;
+    }
+
+    if (Match* match = seat->match) {
+        finishMatch(match);
+        match->seats[seat->player] = nullptr;
+        if (!match->seats[0] && !match->seats[1]) {
+            m_matches.removeOne(match);
+            delete match;
+        }
+    }
+
+    m_seats.removeOne(seat);
+    seat->session->deleteLater();
+    delete seat;
+}
+
+void MatchShard::broadcastSnapshot(Match* match) {
+    const QByteArray blob = match->state.toSnapshot();
+    for (Seat* seat : match->seats) {
+        if (seat) seat->session->sendSnapshot(blob);
+    }
+}
+
+MatchServer::MatchServer(int threadCount, const QVector<QSharedPointer<const HexBoard>>& boards, int rules,
+                         QObject* parent)
+    : QTcpServer(parent)
+{
+    for (int i = 0; i < qMax(1, threadCount); ++i) {
+        QThread* thread = new QThread(this);
+        thread->setObjectName(QString("shard %1").arg(i));   // Shows up in traces
+        MatchShard* shard = new MatchShard(i, boards, rules);
+        shard->moveToThread(thread);
+        connect(thread, &QThread::finished, shard, &QObject::deleteLater);
+        thread->start();
+        m_threads.append(thread);
+        m_shards.append(shard);
+    }
+}
+
+MatchServer::~MatchServer() {
+    close();
+    for (QThread* thread : m_threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+void MatchServer::incomingConnection(qintptr socketDescriptor) {
+    MatchShard* shard = m_shards[int((m_connections / 2) % quint64(m_shards.size()))];
+    ++m_connections;
+
+    // The socket must be created on the shard's own thread
+    QMetaObject::invokeMethod(shard, [shard, socketDescriptor]() {
+        shard->addConnection(socketDescriptor);
+    }, Qt::QueuedConnection);
+}
+
+void MatchServer::printStats() const {
+    int active = 0;
+    int completed = 0;
+    int actions = 0;
+    QStringList perShard;
+    for (const MatchShard* shard : m_shards) {
+        active += shard->activeMatches();
+        completed += shard->completedMatches();
+        actions += shard->actionsApplied();
+        perShard << QString::number(shard->activeMatches());
+    }
+    qInfo().noquote() << QString("matches active=%1 completed=%2 actions=%3 per-thread active=[%4]")
+                         .arg(active).arg(completed).arg(actions).arg(perShard.join(' '));
+}
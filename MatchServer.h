@@ -0,0 +1,101 @@
+// MatchServer.h - Headless server hosting many concurrent matches
+#ifndef MATCHSERVER_H
+#define MATCHSERVER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QTcpServer>
+#include <QVector>
+#include "HexBoard.h"
+#include "MatchState.h"
+
+class NetworkSession;
+class QThread;
+
+// One event loop (thread) worth of matches. Both players of a match are
+// always on the same shard, so a match never needs a lock; the only state
+// shared across shards is the immutable boards and AgentRoster.
+class MatchShard : public QObject {
+    Q_OBJECT
+
+public:
+    // Matches that run longer than this many actions end in a draw
+    static const int MaxActionsPerMatch = 1000;
+
+    // rules: GameSnapshot::Rule flags every match is played with
+    MatchShard(int shardId, const QVector<QSharedPointer<const HexBoard>>& boards, int rules,
+               QObject* parent = nullptr);
+    ~MatchShard();
+
+    // Read from the main thread for statistics
+    int activeMatches() const { return m_activeMatches.loadRelaxed(); }
+    int completedMatches() const { return m_completedMatches.loadRelaxed(); }
+    int actionsApplied() const { return m_actionsApplied.loadRelaxed(); }
+
+public slots:
+    void addConnection(qintptr socketDescriptor);
+
+private:
+    struct Match;
+
+    struct Seat {
+        NetworkSession* session = nullptr;
+        QString name;
+        Match* match = nullptr;
+        int player = -1;
+    };
+
+    struct Match {
+        Match(QSharedPointer<const HexBoard> board, quint32 seed) : state(board, seed) {}
+        MatchState state;
+        Seat* seats[2] = {nullptr, nullptr};
+        int actions = 0;
+        bool finished = false;
+    };
+
+    void onHello(Seat* seat, const QString& name);
+    void onPlace(Seat* seat, const QString& cardName, int cellIndex);
+    void onAction(Seat* seat, int fromCell, int toCell);
+    void onDisconnected(Seat* seat);
+    void startMatch(Seat* first, Seat* second);
+    void finishMatch(Match* match);
+    void broadcastSnapshot(Match* match);
+
+    int m_shardId;
+    QVector<QSharedPointer<const HexBoard>> m_boards;
+    int m_rules;
+    QList<Seat*> m_seats;
+    Seat* m_waiting = nullptr;
+    QList<Match*> m_matches;
+    quint32 m_nextMatchId = 0;
+
+    QAtomicInt m_activeMatches = 0;
+    QAtomicInt m_completedMatches = 0;
+    QAtomicInt m_actionsApplied = 0;
+};
+
+// Accepts connections and deals them to the shards two at a time, so
+// consecutive clients usually meet on the same event loop.
+class MatchServer : public QTcpServer {
+    Q_OBJECT
+
+public:
+    MatchServer(int threadCount, const QVector<QSharedPointer<const HexBoard>>& boards, int rules = 0,
+                QObject* parent = nullptr);
+    ~MatchServer();
+
+    int threadCount() const { return m_shards.size(); }
+    void printStats() const;
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    QVector<QThread*> m_threads;
+    QVector<MatchShard*> m_shards;
+    quint64 m_connections = 0;
+};
+
+#endif // MATCHSERVER_H
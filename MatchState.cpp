@@ -0,0 +1,368 @@
+// MatchState.cpp - Implementation of MatchState
+#include "MatchState.h"
+#include "GameSnapshot.h"
+#include "Log.h"
+#include "TraceRecorder.h"
+
+MatchState::MatchState(QSharedPointer<const HexBoard> board, quint32 seed)
+    : m_board(board), m_occupant(board->cellCount(), -1), m_random(seed)
+{
+}
+
+int MatchState::agentCount(int playerIndex) const {
+    int count = 0;
+    for (const MatchAgent& agent : m_agents) {
+        if (agent.owner == playerIndex) ++count;
+    }
+    return count;
+}
+
+QVector<int> MatchState::validPlacementCells(int playerIndex) const {
+    QVector<int> cells;
+    for (int cell : m_board->placementZone(playerIndex)) {
+        if (m_occupant[cell] < 0) cells.append(cell);
+    }
+    return cells;
+}
+
+bool MatchState::placeAgent(int playerIndex, const AgentDef& def, int cell) {
+    TM_TRACE_SPAN("placement", "match");
+    if (m_battle || cell < 0 || cell >= m_board->cellCount() || m_occupant[cell] >= 0) return false;
+    if (!m_board->placementZone(playerIndex).contains(cell)) return false;
+
+    MatchAgent agent;
+    agent.name = def.name;
+    agent.owner = playerIndex;
+    agent.type = def.type;
+    agent.currentHP = agent.maxHP = def.hp;
+    agent.mobility = agent.remainingMoves = def.mobility;
+    agent.damage = def.damage;
+    agent.attackRange = def.attackRange;
+
+    // Keep ids in roster order: player 1's agents first
+    int position = m_agents.size();
+    if (playerIndex == 0) {
+        position = 0;
+        while (position < m_agents.size() && m_agents[position].owner == 0) ++position;
+    }
+    m_agents.insert(position, agent);
+
+    m_occupant.fill(-1);
+    m_agents[position].cell = cell;
+    for (int id = 0; id < m_agents.size(); ++id) {
+        if (m_agents[id].cell >= 0) m_occupant[m_agents[id].cell] = id;
+    }
+    if (m_fogOfWar) m_fog.addViewer(playerIndex, cell);
+    syncThreats();
+    return true;
+}
+
+void MatchState::setLineOfSight(bool enabled) {
+    m_lineOfSight = enabled;
+    if (m_fogOfWar) rebuildFog();   // Rock hides cells too now
+    if (m_threatTracking) setThreatTracking(true);
+}
+
+void MatchState::setFogOfWar(bool enabled) {
+    m_fogOfWar = enabled;
+    if (m_fogOfWar) rebuildFog();
+}
+
+void MatchState::rebuildFog() {
+    m_fog.reset(m_board, m_lineOfSight);
+    for (const MatchAgent& agent : m_agents) {
+        if (agent.isAlive()) m_fog.addViewer(agent.owner, agent.cell);
+    }
+}
+
+void MatchState::setThreatTracking(bool enabled) {
+    m_threatTracking = enabled;
+    if (m_threatTracking) {
+        m_threats.reset(m_board, m_lineOfSight);
+        syncThreats();
+    }
+}
+
+void MatchState::syncThreats() {
+    if (!m_threatTracking) return;
+    // Unchanged agents are skipped inside ThreatMap, so this stays cheap
+    for (int id = 0; id < m_agents.size(); ++id) {
+        const MatchAgent& agent = m_agents[id];
+        ThreatSource source;
+        source.owner = agent.owner;
+        source.type = agent.type;
+        source.cell = agent.isAlive() ? agent.cell : -1;
+        source.moves = agent.owner == m_currentPlayer ? agent.remainingMoves : agent.mobility;
+        source.damage = agent.damage;
+        source.attackRange = agent.attackRange;
+        m_threats.setAgent(id, source);
+    }
+    m_threats.setAgentCount(m_agents.size());
+}
+
+void MatchState::startBattle() {
+    m_battle = true;
+    m_currentPlayer = 0;
+    for (MatchAgent& agent : m_agents) {
+        agent.remainingMoves = agent.mobility;
+    }
+    syncThreats();
+}
+
+bool MatchState::hasAliveAgents(int playerIndex) const {
+    for (const MatchAgent& agent : m_agents) {
+        if (agent.owner == playerIndex && agent.isAlive()) return true;
+    }
+    return false;
+}
+
+bool MatchState::isGameOver() const {
+    return !hasAliveAgents(0) || !hasAliveAgents(1);
+}
+
+int MatchState::winner() const {
+    if (!hasAliveAgents(0)) return 1;
+    if (!hasAliveAgents(1)) return 0;
+    return -1;
+}
+
+QVector<int> MatchState::reachableCells(int agentId) const {
+    QVector<int> reachable;
+    const MatchAgent& agent = m_agents[agentId];
+    if (agent.cell < 0 || agent.remainingMoves <= 0) return reachable;
+
+    GameRules::searchMoves(m_search, *m_board, agent.type, agent.cell, agent.remainingMoves,
+                           [&](int cell) { return m_occupant[cell] >= 0; });
+    for (int cell : m_search.settled()) {
+        if (cell != agent.cell && GameRules::canPlaceOn(agent.type, m_board->terrain(cell))) {
+            reachable.append(cell);
+        }
+    }
+    return reachable;
+}
+
+QVector<int> MatchState::cellsInRange(int cell, int range) const {
+    return m_range.run(*m_board, cell, range);
+}
+
+int MatchState::pathDistance(int agentId, int target) const {
+    const MatchAgent& agent = m_agents[agentId];
+    if (agent.cell < 0 || target < 0 || agent.cell == target) return 0;
+    return GameRules::pathCost(m_search, *m_board, agent.type, agent.cell, target,
+                               [&](int cell) { return m_occupant[cell] >= 0; });
+}
+
+int MatchState::moveCost(int agentId, int cell) const {
+    const MatchAgent& agent = m_agents[agentId];
+    if (!agent.isAlive()) return -1;
+    return GameRules::moveCost(m_search, *m_board, agent.type, agent.cell, cell, agent.remainingMoves,
+                               [&](int index) { return m_occupant[index] >= 0; });
+}
+
+bool MatchState::canMoveTo(int agentId, int cell) const {
+    return moveCost(agentId, cell) >= 0;
+}
+
+bool MatchState::canAttack(int agentId, int targetId) const {
+    const MatchAgent& agent = m_agents[agentId];
+    const MatchAgent& target = m_agents[targetId];
+    if (!agent.isAlive() || !target.isAlive() || agent.owner == target.owner) return false;
+    if (m_lineOfSight && !m_board->isVisible(agent.cell, target.cell)) return false;
+    return m_range.reaches(*m_board, agent.cell, target.cell, agent.attackRange);
+}
+
+void MatchState::setAgentCell(int agentId, int cell) {
+    MatchAgent& agent = m_agents[agentId];
+    if (m_fogOfWar) m_fog.moveViewer(agent.owner, agent.cell, cell);
+    if (agent.cell >= 0 && m_occupant[agent.cell] == agentId) {
+        m_occupant[agent.cell] = -1;
+    }
+    agent.cell = cell;
+    if (cell >= 0) {
+        m_occupant[cell] = agentId;
+    }
+}
+
+void MatchState::takeDamage(int agentId, int amount) {
+    MatchAgent& agent = m_agents[agentId];
+    agent.currentHP = qMax(0, agent.currentHP - amount);
+    if (!agent.isAlive()) {
+        setAgentCell(agentId, -1);
+    }
+}
+
+void MatchState::endTurn() {
+    m_currentPlayer = GameRules::nextPlayer(m_currentPlayer);
+    for (MatchAgent& agent : m_agents) {
+        if (agent.owner == m_currentPlayer && agent.isAlive()) {
+            agent.remainingMoves = agent.mobility;
+        }
+    }
+}
+
+bool MatchState::performAction(int fromCell, int toCell, GameDelta* delta) {
+    TM_TRACE_SPAN("action", "match");
+    const int cellCount = m_board->cellCount();
+    if (!m_battle || isGameOver()) return false;
+    if (fromCell < 0 || fromCell >= cellCount || toCell < 0 || toCell >= cellCount) return false;
+
+    const int agentId = m_occupant[fromCell];
+    if (agentId < 0 || m_agents[agentId].owner != m_currentPlayer) return false;
+
+    const QVector<MatchAgent> before = delta ? m_agents : QVector<MatchAgent>();
+    const int playerBefore = m_currentPlayer;
+
+    bool actionPerformed = false;
+    const int targetId = m_occupant[toCell];
+    const int cost = moveCost(agentId, toCell);
+    if (cost >= 0) {
+        m_agents[agentId].remainingMoves -= cost;
+        setAgentCell(agentId, toCell);
+        actionPerformed = true;
+    } else if (targetId >= 0 && canAttack(agentId, targetId)) {
+        // See GameRules::counterDamage
+        takeDamage(targetId, m_agents[agentId].damage);
+        takeDamage(agentId, GameRules::counterDamage(m_agents[agentId].damage));
+
+        if (m_agents[agentId].isAlive()) {
+            const int landing = GameRules::landingCell(*m_board, m_agents[agentId].type, m_agents[targetId].cell,
+                                                       m_random, [&](int cell) { return m_occupant[cell] >= 0; });
+            if (landing >= 0) setAgentCell(agentId, landing);
+        }
+        actionPerformed = true;
+    }
+
+    if (!actionPerformed) return false;
+
+    if (!isGameOver()) {
+        endTurn();
+    }
+    syncThreats();
+
+    if (delta) {
+        delta->agents.clear();
+        delta->playerBefore = playerBefore;
+        delta->playerAfter = m_currentPlayer;
+        for (int id = 0; id < m_agents.size(); ++id) {
+            const MatchAgent& was = before[id];
+            const MatchAgent& now = m_agents[id];
+            if (was.cell != now.cell || was.currentHP != now.currentHP
+                || was.remainingMoves != now.remainingMoves) {
+                AgentDelta change;
+                change.agentId = id;
+                change.cellBefore = was.cell;
+                change.cellAfter = now.cell;
+                change.hpBefore = was.currentHP;
+                change.hpAfter = now.currentHP;
+                change.movesBefore = was.remainingMoves;
+                change.movesAfter = now.remainingMoves;
+                delta->agents.append(change);
+            }
+        }
+    }
+    return true;
+}
+
+void MatchState::applyDelta(const GameDelta& delta, bool reverse) {
+    // Lift first, then place, as GamePage::applyDelta does
+    for (const AgentDelta& change : delta.agents) {
+        if (change.agentId >= 0 && change.agentId < m_agents.size()) {
+            setAgentCell(change.agentId, -1);
+        }
+    }
+    for (const AgentDelta& change : delta.agents) {
+        if (change.agentId < 0 || change.agentId >= m_agents.size()) continue;
+        MatchAgent& agent = m_agents[change.agentId];
+        agent.currentHP = reverse ? change.hpBefore : change.hpAfter;
+        agent.remainingMoves = reverse ? change.movesBefore : change.movesAfter;
+        const int cell = reverse ? change.cellBefore : change.cellAfter;
+        if (agent.isAlive() && cell >= 0 && cell < m_board->cellCount()) {
+            setAgentCell(change.agentId, cell);
+        }
+    }
+    m_currentPlayer = reverse ? delta.playerBefore : delta.playerAfter;
+    syncThreats();
+}
+
+quint32 MatchState::stateChecksum(quint32 previous) const {
+    StateChecksum checksum(previous);
+    for (const MatchAgent& agent : m_agents) {
+        checksum.add(agent.cell);
+        checksum.add(agent.currentHP);
+        checksum.add(agent.remainingMoves);
+    }
+    checksum.add(m_currentPlayer);
+    checksum.add(qint32(m_random.state()));
+    return checksum.value();
+}
+
+QByteArray MatchState::toSnapshot() const {
+    QVector<GameSnapshot::CellState> cells;
+    cells.reserve(m_board->cellCount());
+    for (int i = 0; i < m_board->cellCount(); ++i) {
+        GameSnapshot::CellState cell;
+        cell.row = m_board->row(i);
+        cell.col = m_board->col(i);
+        cell.type = m_board->terrain(i);
+        cell.zone = m_board->zone(i);
+        cells.append(cell);
+    }
+
+    QVector<GameSnapshot::AgentState> agents;
+    agents.reserve(m_agents.size());
+    for (const MatchAgent& agent : m_agents) {
+        GameSnapshot::AgentState state;
+        state.name = agent.name;
+        state.owner = agent.owner;
+        state.type = agent.type;
+        state.cellIndex = agent.cell;
+        state.currentHP = agent.currentHP;
+        state.maxHP = agent.maxHP;
+        state.mobility = agent.mobility;
+        state.remainingMoves = agent.remainingMoves;
+        state.damage = agent.damage;
+        state.attackRange = agent.attackRange;
+        agents.append(state);
+    }
+
+    return GameSnapshot::write(m_board->name(), m_currentPlayer,
+                               m_battle ? GameSnapshot::Battle : GameSnapshot::Placement,
+                               cells, agents, (m_lineOfSight ? GameSnapshot::LineOfSight : 0)
+                                              | (m_fogOfWar ? GameSnapshot::Fog : 0));
+}
+
+bool MatchState::loadSnapshot(const GameSnapshot& snapshot) {
+    QString error;
+    if (!snapshot.check(*m_board, &error)) {
+        TM_LOG_WARNING("Cannot load snapshot: %1", error);
+        return false;
+    }
+
+    m_agents.clear();
+    m_occupant.fill(-1);
+    m_fogOfWar = false;   // Rebuilt in one go below
+    for (int i = 0; i < snapshot.agentCount(); ++i) {
+        const GameSnapshot::AgentRecord& record = snapshot.agent(i);
+        MatchAgent agent;
+        agent.name = snapshot.agentName(i);
+        agent.owner = record.owner;
+        agent.type = AgentType(record.type);
+        agent.currentHP = record.currentHP;
+        agent.maxHP = record.maxHP;
+        agent.mobility = record.mobility;
+        agent.remainingMoves = record.remainingMoves;
+        agent.damage = record.damage;
+        agent.attackRange = record.attackRange;
+        m_agents.append(agent);
+        if (agent.isAlive() && record.cellIndex >= 0) {
+            setAgentCell(i, record.cellIndex);
+        }
+    }
+
+    m_currentPlayer = snapshot.header().currentPlayer;
+    m_battle = snapshot.header().phase == GameSnapshot::Battle;
+    m_lineOfSight = snapshot.header().rules & GameSnapshot::LineOfSight;
+    setFogOfWar(snapshot.header().rules & GameSnapshot::Fog);
+    if (m_threatTracking) setThreatTracking(true);   // The line of sight rule may have changed
+    return true;
+}
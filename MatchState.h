@@ -0,0 +1,131 @@
+// MatchState.h - Headless game rules for one match (no graphics items)
+#ifndef MATCHSTATE_H
+#define MATCHSTATE_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "AgentRoster.h"
+#include "AgentType.h"
+#include "DistanceField.h"
+#include "FogOfWar.h"
+#include "GameHistory.h"
+#include "GameRules.h"
+#include "HexBoard.h"
+#include "Lockstep.h"
+#include "MoveCosts.h"
+#include "ThreatMap.h"
+
+class GameSnapshot;
+
+struct MatchAgent {
+    QString name;
+    int owner = 0;          // 0 = player 1, 1 = player 2
+    AgentType type = Grounded;
+    int cell = -1;          // -1 once dead
+    int currentHP = 0;
+    int maxHP = 0;
+    int mobility = 0;
+    int remainingMoves = 0;
+    int damage = 0;
+    int attackRange = 0;
+
+    bool isAlive() const { return currentHP > 0; }
+};
+
+// The rules of GameRules.h, on plain data, so a server can run many
+// matches per thread and bots can search without a QGraphicsScene. Agent ids
+// follow the GameSnapshot/GameDelta order: player 1's agents, then player 2's.
+class MatchState {
+public:
+    explicit MatchState(QSharedPointer<const HexBoard> board, quint32 seed = 1);
+
+    const HexBoard& board() const { return *m_board; }
+    QSharedPointer<const HexBoard> sharedBoard() const { return m_board; }
+    const QVector<MatchAgent>& agents() const { return m_agents; }
+    int agentAt(int cell) const { return m_occupant[cell]; }
+    int agentCount(int playerIndex) const;
+
+    // Placement
+    QVector<int> validPlacementCells(int playerIndex) const;
+    bool placeAgent(int playerIndex, const AgentDef& def, int cell);
+    void startBattle();
+
+    // Battle
+    bool isBattle() const { return m_battle; }
+    int currentPlayer() const { return m_currentPlayer; }
+    bool hasAliveAgents(int playerIndex) const;
+    bool isGameOver() const;
+    int winner() const;     // -1 while nobody has won
+
+    // Movement is priced by MoveCosts: reachable means the agent's
+    // remaining moves cover the cheapest path, and pathDistance is its cost
+    QVector<int> reachableCells(int agentId) const;
+    QVector<int> cellsInRange(int cell, int range) const;
+    int pathDistance(int agentId, int target) const;
+    bool canMoveTo(int agentId, int cell) const;
+    int moveCost(int agentId, int cell) const;   // -1 unless canMoveTo
+    bool canAttack(int agentId, int targetId) const;
+
+    // Moves from every cell to the nearest of sources, per agent type, with
+    // the agents as obstacles (see DistanceField.h). One pass for all agents
+    // where pathDistance would take one search per agent and target.
+    void distancesTo(const QVector<int>& sources, DistanceField& field) const {
+        field.compute(*m_board, sources, m_occupant);
+    }
+
+    // Optional rule: Rock blocks attacks (see HexBoard::isVisible)
+    void setLineOfSight(bool enabled);
+    bool lineOfSight() const { return m_lineOfSight; }
+
+    // Optional rule: fog of war. Nothing in the rules depends on it; it is
+    // what a player (or a bot playing as one) is allowed to look at.
+    void setFogOfWar(bool enabled);
+    bool fogOfWar() const { return m_fogOfWar; }
+    bool isVisibleTo(int playerIndex, int cell) const {
+        return !m_fogOfWar || (cell >= 0 && m_fog.isVisible(playerIndex, cell));
+    }
+
+    // Threat map (see ThreatMap.h), kept current only while tracking is on.
+    // The player to move counts with the moves left, the other player with
+    // a full turn's.
+    void setThreatTracking(bool enabled);
+    bool threatTracking() const { return m_threatTracking; }
+    const ThreatMap& threats() const { return m_threats; }
+
+    // Applies the action the way a click on toCell with the agent on
+    // fromCell selected would, then passes the turn. Fills delta if given.
+    bool performAction(int fromCell, int toCell, GameDelta* delta = nullptr);
+    void applyDelta(const GameDelta& delta, bool reverse = false);
+
+    // Same fields, same order as GamePage::stateChecksum
+    quint32 stateChecksum(quint32 previous) const;
+
+    // Interop with the GUI and the network protocol
+    QByteArray toSnapshot() const;
+    bool loadSnapshot(const GameSnapshot& snapshot);   // Leaves the match as is unless GameSnapshot::check passes
+
+private:
+    void setAgentCell(int agentId, int cell);
+    void takeDamage(int agentId, int amount);
+    void endTurn();
+    void rebuildFog();
+    void syncThreats();
+
+    QSharedPointer<const HexBoard> m_board;
+    QVector<MatchAgent> m_agents;
+    QVector<int> m_occupant;    // Agent id per cell, -1 when empty
+    int m_currentPlayer = 0;
+    bool m_battle = false;
+    bool m_lineOfSight = false;
+    bool m_fogOfWar = false;
+    FogOfWar m_fog;             // Maintained only while m_fogOfWar is on
+    bool m_threatTracking = false;
+    ThreatMap m_threats;
+    LockstepRandom m_random;
+    mutable MoveSearch m_search;   // Scratch space for the movement queries
+    mutable RangeSearch m_range;   // ... and for the attack range ones
+};
+
+#endif // MATCHSTATE_H
@@ -0,0 +1,81 @@
+// MoveAnimator.cpp - Implementation of MoveAnimator
+#include "MoveAnimator.h"
+#include <QTimer>
+#include "agent.h"
+
+MoveAnimator::MoveAnimator(QObject* parent) : QObject(parent) {
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(16);
+    connect(m_timer, &QTimer::timeout, this, &MoveAnimator::tick);
+    m_clock.start();
+}
+
+void MoveAnimator::animate(Agent* agent, const QVector<QPointF>& waypoints) {
+    if (!agent || waypoints.isEmpty()) return;
+
+    for (int i = 0; i < m_tracks.size(); ++i) {
+        if (m_tracks[i].agent == agent) {
+            m_tracks.removeAt(i);
+            break;
+        }
+    }
+
+    if (!m_enabled || waypoints.size() < 2) {
+        agent->setPos(waypoints.last());
+        return;
+    }
+
+    Track track;
+    track.agent = agent;
+    track.waypoints = waypoints;
+    track.startMs = m_clock.elapsed();
+    track.durationMs = qMin<qint64>(MaxDurationMs, qint64(StepMs) * (waypoints.size() - 1));
+    m_tracks.append(track);
+
+    agent->setPos(waypoints.first());
+    if (!m_timer->isActive()) m_timer->start();
+}
+
+void MoveAnimator::finishAll() {
+    for (const Track& track : m_tracks) {
+        if (track.agent) track.agent->setPos(track.waypoints.last());
+    }
+    m_tracks.clear();
+    m_timer->stop();
+}
+
+void MoveAnimator::setEnabled(bool enabled) {
+    m_enabled = enabled;
+    if (!enabled) finishAll();
+}
+
+void MoveAnimator::tick() {
+    const qint64 now = m_clock.elapsed();
+
+    for (int i = m_tracks.size() - 1; i >= 0; --i) {
+        const Track& track = m_tracks[i];
+        if (!track.agent) {
+            m_tracks.removeAt(i);
+            continue;
+        }
+
+        const double progress = double(now - track.startMs) / track.durationMs;
+        if (progress >= 1.0) {
+            track.agent->setPos(track.waypoints.last());
+            m_tracks.removeAt(i);
+        } else {
+            track.agent->setPos(positionAt(track.waypoints, progress));
+        }
+    }
+
+    if (m_tracks.isEmpty()) m_timer->stop();
+}
+
+QPointF MoveAnimator::positionAt(const QVector<QPointF>& waypoints, double progress) {
+    // Same time for every hex: the waypoints are cell centres, all equally far apart
+    const double position = progress * (waypoints.size() - 1);
+    const int segment = qMin(int(position), int(waypoints.size()) - 2);
+    const double t = position - segment;
+    return waypoints[segment] + (waypoints[segment + 1] - waypoints[segment]) * t;
+}
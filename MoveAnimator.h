@@ -0,0 +1,56 @@
+// MoveAnimator.h - Shared timeline that slides agent sprites along their paths
+#ifndef MOVEANIMATOR_H
+#define MOVEANIMATOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QVector>
+
+class Agent;
+class QTimer;
+
+// Purely visual: the agent is already on its destination cell when an
+// animation starts, only the sprite lags behind. One timer advances every
+// moving sprite per tick, whatever the number of agents in motion.
+//
+// Anything that changes the board again (the next action, undo, a remote
+// delta) calls finishAll() first, so fast replays or bots just see every
+// move snap to its end.
+class MoveAnimator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MoveAnimator(QObject* parent = nullptr);
+
+    // Waypoints are scene positions, first to last; the sprite ends on the
+    // last one. Replaces any animation the agent still had running.
+    void animate(Agent* agent, const QVector<QPointF>& waypoints);
+    void finishAll();
+
+    bool isAnimating() const { return !m_tracks.isEmpty(); }
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    static const int StepMs = 120;        // Per hex
+    static const int MaxDurationMs = 400; // Long paths move faster
+
+private:
+    struct Track {
+        QPointer<Agent> agent;   // Cleared if the sprite is deleted mid-move
+        QVector<QPointF> waypoints;
+        qint64 startMs = 0;
+        qint64 durationMs = 0;
+    };
+
+    void tick();
+    static QPointF positionAt(const QVector<QPointF>& waypoints, double progress);
+
+    QTimer* m_timer;
+    QElapsedTimer m_clock;
+    QVector<Track> m_tracks;
+    bool m_enabled = true;
+};
+
+#endif // MOVEANIMATOR_H
@@ -0,0 +1,83 @@
+// MoveCosts.cpp - Implementation of MoveCosts
+#include "MoveCosts.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QStringList>
+#include "Log.h"
+
+namespace {
+
+const char* const TypeNames[] = {"WaterWalking", "Grounded", "Flying", "Floating"};   // AgentType order
+
+// What the rules were before the table existed: every step costs one move
+MoveCosts fallbackCosts() {
+    MoveCosts costs;
+    MoveCosts::parse("WaterWalking 1 1 0 1\n"
+                     "Grounded     1 0 0 1\n"
+                     "Flying       1 1 1 1\n"
+                     "Floating     1 1 1 1\n", costs);
+    return costs;
+}
+
+MoveCosts loadStandard() {
+    const QString path = ":/new/prefix1/movecosts.txt";
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        TM_LOG_WARNING("Cannot open %1, every step costs one move", path);
+        return fallbackCosts();
+    }
+
+    MoveCosts costs;
+    QString error;
+    if (!MoveCosts::parse(QString::fromUtf8(file.readAll()), costs, &error)) {
+        TM_LOG_WARNING("%1: %2, every step costs one move", path, error);
+        return fallbackCosts();
+    }
+    return costs;
+}
+
+}
+
+const MoveCosts& MoveCosts::standard() {
+    static const MoveCosts costs = loadStandard();
+    return costs;
+}
+
+bool MoveCosts::parse(const QString& text, MoveCosts& out, QString* error) {
+    MoveCosts costs;
+    bool seen[4] = {false, false, false, false};
+
+    const QStringList lines = text.split('\n');
+    for (int lineIndex = 0; lineIndex < lines.size(); ++lineIndex) {
+        const QString line = lines[lineIndex].trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        const QStringList fields = line.split(QRegularExpression("\\s+"));
+        int type = 0;
+        while (type < 4 && fields[0] != QLatin1String(TypeNames[type])) ++type;
+        if (type == 4 || fields.size() != 5) {
+            if (error) *error = QString("line %1 is not \"<agent type> <4 costs>\"").arg(lineIndex + 1);
+            return false;
+        }
+
+        for (int terrain = 0; terrain < 4; ++terrain) {
+            bool ok = false;
+            const int cost = fields[terrain + 1].toInt(&ok);
+            if (!ok || cost < 0 || cost > MaxCost) {
+                if (error) *error = QString("line %1: cost must be 0 to %2").arg(lineIndex + 1).arg(MaxCost);
+                return false;
+            }
+            costs.m_cost[type][terrain] = quint8(cost);
+        }
+        seen[type] = true;
+    }
+
+    for (int type = 0; type < 4; ++type) {
+        if (!seen[type]) {
+            if (error) *error = QString("no costs for %1").arg(QLatin1String(TypeNames[type]));
+            return false;
+        }
+    }
+    out = costs;
+    return true;
+}
@@ -0,0 +1,105 @@
+// MoveCosts.h - What stepping onto each terrain costs each agent type, and the cheapest-move search
+#ifndef MOVECOSTS_H
+#define MOVECOSTS_H
+
+#include <QString>
+#include <QVector>
+#include "AgentType.h"
+#include "HexBoard.h"
+
+// Moves an agent spends to step onto a cell, per agent type and terrain; 0
+// means the type can't pass there at all. The table is data (movecosts.txt
+// in grids.qrc), loaded once and shared read-only by every thread.
+class MoveCosts {
+public:
+    static const int MaxCost = 9;   // One digit per entry in the table
+
+    static const MoveCosts& standard();
+    static bool parse(const QString& text, MoveCosts& out, QString* error = nullptr);
+
+    int cost(AgentType type, HexBoard::Terrain terrain) const { return m_cost[type][terrain]; }
+    bool canPass(AgentType type, HexBoard::Terrain terrain) const { return m_cost[type][terrain] > 0; }
+
+private:
+    quint8 m_cost[4][4] = {};   // [AgentType][Terrain]
+};
+
+// Dial's algorithm: Dijkstra with one bucket per cost value, which for costs
+// of 1..MaxCost is as cheap as a breadth-first search. Keep one around and
+// reuse it; each run only resets the cells the previous run touched.
+class MoveSearch {
+public:
+    static const int Unreached = -1;
+
+    // Cheapest cost from start to every cell within budget (-1 = no limit),
+    // or until target is settled. enterCost(cell) is what stepping onto the
+    // cell costs, 0 if it can't be entered.
+    template <typename EnterCost>
+    void run(const HexBoard& board, int start, int budget, EnterCost enterCost, int target = -1);
+
+    int cost(int cell) const { return m_cost[cell]; }
+    int parent(int cell) const { return m_parent[cell]; }
+    const QVector<int>& settled() const { return m_settled; }   // Cheapest first, start included
+
+private:
+    QVector<int> m_cost;
+    QVector<int> m_parent;
+    QVector<int> m_touched;
+    QVector<int> m_settled;
+    QVector<int> m_buckets[MoveCosts::MaxCost + 1];
+};
+
+template <typename EnterCost>
+void MoveSearch::run(const HexBoard& board, int start, int budget, EnterCost enterCost, int target) {
+    const int cells = board.cellCount();
+    if (m_cost.size() != cells) {
+        m_cost.fill(Unreached, cells);
+        m_parent.fill(-1, cells);
+    } else {
+        for (int cell : m_touched) m_cost[cell] = Unreached;
+    }
+    m_touched.clear();
+    m_settled.clear();
+    if (start < 0 || start >= cells) return;
+
+    const int buckets = MoveCosts::MaxCost + 1;
+    m_cost[start] = 0;
+    m_parent[start] = start;
+    m_touched.append(start);
+    m_buckets[0].append(start);
+    int pending = 1;
+
+    for (int distance = 0; pending > 0; ++distance) {
+        QVector<int>& bucket = m_buckets[distance % buckets];
+        for (int i = 0; i < bucket.size(); ++i) {
+            const int cell = bucket[i];
+            --pending;
+            if (m_cost[cell] != distance) continue;   // Found cheaper after it was queued
+            m_settled.append(cell);
+            if (cell == target) {
+                for (QVector<int>& rest : m_buckets) rest.clear();
+                return;
+            }
+
+            for (const int* it = board.neighborsBegin(cell); it != board.neighborsEnd(cell); ++it) {
+                const int neighbor = *it;
+                const int step = qMin(int(enterCost(neighbor)), int(MoveCosts::MaxCost));
+                if (step <= 0) continue;
+                const int reached = distance + step;
+                if (budget >= 0 && reached > budget) continue;
+                if (m_cost[neighbor] == Unreached) {
+                    m_touched.append(neighbor);
+                } else if (m_cost[neighbor] <= reached) {
+                    continue;
+                }
+                m_cost[neighbor] = reached;
+                m_parent[neighbor] = cell;
+                m_buckets[reached % buckets].append(neighbor);
+                ++pending;
+            }
+        }
+        bucket.clear();
+    }
+}
+
+#endif // MOVECOSTS_H
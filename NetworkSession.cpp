@@ -0,0 +1,333 @@
+// NetworkSession.cpp - Implementation of NetworkSession
+#include "NetworkSession.h"
+#include "Log.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+
+namespace {
+
+void appendU8(QByteArray& out, quint8 value) {
+    out.append(char(value));
+}
+
+void appendI32(QByteArray& out, qint32 value) {
+    char bytes[4];
+    qToLittleEndian<qint32>(value, bytes);
+    out.append(bytes, 4);
+}
+
+void appendU32(QByteArray& out, quint32 value) {
+    char bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    out.append(bytes, 4);
+}
+
+}
+
+NetworkSession::NetworkSession(QObject* parent) : QObject(parent) {
+}
+
+NetworkSession::~NetworkSession() {
+    close();
+}
+
+bool NetworkSession::isConnected() const {
+    return m_socket && m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool NetworkSession::host(quint16 port) {
+    close();
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &NetworkSession::onNewConnection);
+    if (!m_server->listen(QHostAddress::Any, port)) {
+        emit errorOccurred(QString("Cannot listen on port %1: %2").arg(port).arg(m_server->errorString()));
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+
+    m_role = Host;
+    TM_LOG_INFO("Hosting on port %1", port);
+    return true;
+}
+
+void NetworkSession::join(const QString& address, quint16 port) {
+    close();
+
+    m_role = Client;
+    QTcpSocket* socket = new QTcpSocket(this);
+    attachSocket(socket);
+    connect(socket, &QTcpSocket::connected, this, &NetworkSession::connected);
+    socket->connectToHost(address, port);
+}
+
+bool NetworkSession::adoptDescriptor(qintptr socketDescriptor) {
+    close();
+
+    QTcpSocket* socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        return false;
+    }
+    m_role = Host;
+    attachSocket(socket);
+    return true;
+}
+
+void NetworkSession::close() {
+    if (m_socket) {
+        m_socket->disconnect(this);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+    if (m_server) {
+        m_server->close();
+        delete m_server;
+        m_server = nullptr;
+    }
+    m_buffer.clear();
+    m_role = Offline;
+}
+
+void NetworkSession::closeGracefully() {
+    if (m_socket) {
+        m_socket->disconnectFromHost();
+    }
+}
+
+void NetworkSession::attachSocket(QTcpSocket* socket) {
+    m_socket = socket;
+    m_buffer.clear();
+
+    // Messages are tiny and latency bound; don't let Nagle hold them back
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    connect(m_socket, &QTcpSocket::readyRead, this, &NetworkSession::onReadyRead);
+    connect(m_socket, &QTcpSocket::disconnected, this, &NetworkSession::onSocketDisconnected);
+    connect(m_socket, &QAbstractSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+        if (m_socket) emit errorOccurred(m_socket->errorString());
+    });
+}
+
+void NetworkSession::onNewConnection() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        // Two-player game: one opponent per host
+        if (m_socket) {
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+        attachSocket(socket);
+        emit connected();
+    }
+}
+
+void NetworkSession::onSocketDisconnected() {
+    if (m_socket) {
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+    m_buffer.clear();
+    emit disconnected();
+}
+
+void NetworkSession::onReadyRead() {
+    m_buffer.append(m_socket->readAll());
+
+    // Dispatch every complete frame in the buffer
+    int offset = 0;
+    while (m_buffer.size() - offset >= 4) {
+        const quint32 length = qFromLittleEndian<quint32>(m_buffer.constData() + offset);
+        if (length == 0 || length > 1024 * 1024) {
+            emit errorOccurred("Malformed message from peer");
+            close();
+            return;
+        }
+        if (quint32(m_buffer.size() - offset - 4) < length) break;
+
+        const MessageType type = MessageType(quint8(m_buffer.at(offset + 4)));
+        const QByteArray payload = m_buffer.mid(offset + 5, int(length) - 1);
+        offset += 4 + int(length);
+        dispatch(type, payload);
+
+        // A handler may have closed the session
+        if (!m_socket) return;
+    }
+    m_buffer.remove(0, offset);
+}
+
+void NetworkSession::send(MessageType type, const QByteArray& payload) {
+    if (!isConnected()) return;
+
+    QByteArray frame;
+    frame.reserve(5 + payload.size());
+    appendU32(frame, quint32(payload.size() + 1));
+    appendU8(frame, type);
+    frame.append(payload);
+    m_socket->write(frame);
+}
+
+void NetworkSession::dispatch(MessageType type, const QByteArray& payload) {
+    switch (type) {
+    case Hello:
+        emit helloReceived(QString::fromUtf8(payload));
+        break;
+    case Welcome:
+        emit welcomeReceived(QString::fromUtf8(payload));
+        break;
+    case Snapshot:
+        emit snapshotReceived(payload);
+        break;
+    case Action:
+        if (payload.size() == 8) {
+            emit actionReceived(qFromLittleEndian<qint32>(payload.constData()),
+                                qFromLittleEndian<qint32>(payload.constData() + 4));
+        }
+        break;
+    case Place:
+        if (payload.size() >= 4) {
+            emit placeReceived(QString::fromUtf8(payload.mid(4)),
+                               qFromLittleEndian<qint32>(payload.constData()));
+        }
+        break;
+    case Delta: {
+        GameDelta delta;
+        if (decodeDelta(payload, delta)) {
+            emit deltaReceived(delta);
+        }
+        break;
+    }
+    case Seat:
+        if (payload.size() == 1) {
+            emit seatReceived(quint8(payload.at(0)));
+        }
+        break;
+    case LockstepStart:
+        if (payload.size() == 4) {
+            emit lockstepStartReceived(qFromLittleEndian<quint32>(payload.constData()));
+        }
+        break;
+    case LockstepAction:
+        if (payload.size() == 12) {
+            emit lockstepActionReceived(qFromLittleEndian<qint32>(payload.constData()),
+                                        qFromLittleEndian<qint32>(payload.constData() + 4),
+                                        qFromLittleEndian<quint32>(payload.constData() + 8));
+        }
+        break;
+    case Resync:
+        emit resyncRequested();
+        break;
+    default:
+        TM_LOG_WARNING("Ignoring unknown message type %1", int(type));
+        break;
+    }
+}
+
+void NetworkSession::sendHello(const QString& playerName) {
+    send(Hello, playerName.toUtf8());
+}
+
+void NetworkSession::sendWelcome(const QString& playerName) {
+    send(Welcome, playerName.toUtf8());
+}
+
+void NetworkSession::sendSnapshot(const QByteArray& blob) {
+    send(Snapshot, blob);
+}
+
+void NetworkSession::sendAction(int fromCell, int toCell) {
+    QByteArray payload;
+    appendI32(payload, fromCell);
+    appendI32(payload, toCell);
+    send(Action, payload);
+}
+
+void NetworkSession::sendPlace(const QString& cardName, int cellIndex) {
+    QByteArray payload;
+    appendI32(payload, cellIndex);
+    payload.append(cardName.toUtf8());
+    send(Place, payload);
+}
+
+void NetworkSession::sendDelta(const GameDelta& delta) {
+    send(Delta, encodeDelta(delta));
+}
+
+void NetworkSession::sendSeat(int playerIndex) {
+    QByteArray payload;
+    appendU8(payload, quint8(playerIndex));
+    send(Seat, payload);
+}
+
+void NetworkSession::sendLockstepStart(quint32 seed) {
+    QByteArray payload;
+    appendU32(payload, seed);
+    send(LockstepStart, payload);
+}
+
+void NetworkSession::sendLockstepAction(int fromCell, int toCell, quint32 checksum) {
+    QByteArray payload;
+    appendI32(payload, fromCell);
+    appendI32(payload, toCell);
+    appendU32(payload, checksum);
+    send(LockstepAction, payload);
+}
+
+void NetworkSession::sendResync() {
+    send(Resync, QByteArray());
+}
+
+QByteArray NetworkSession::encodeDelta(const GameDelta& delta) {
+    QByteArray out;
+    out.reserve(5 + delta.agents.size() * 16);
+    appendU8(out, quint8(delta.playerAfter));
+    appendI32(out, delta.agents.size());
+    for (const AgentDelta& change : delta.agents) {
+        appendI32(out, change.agentId);
+        appendI32(out, change.cellAfter);
+        appendI32(out, change.hpAfter);
+        appendI32(out, change.movesAfter);
+    }
+    return out;
+}
+
+bool NetworkSession::decodeDelta(const QByteArray& payload, GameDelta& delta) {
+    if (payload.size() < 5) return false;
+
+    const char* in = payload.constData();
+    const qint32 count = qFromLittleEndian<qint32>(in + 1);
+    if (count < 0 || count > (payload.size() - 5) / 16 || payload.size() != 5 + count * 16) return false;
+
+    delta.playerBefore = delta.playerAfter = quint8(in[0]);
+    delta.agents.clear();
+    delta.agents.reserve(count);
+    in += 5;
+    for (int i = 0; i < count; ++i, in += 16) {
+        AgentDelta change;
+        change.agentId = qFromLittleEndian<qint32>(in);
+        change.cellAfter = qFromLittleEndian<qint32>(in + 4);
+        change.hpAfter = qFromLittleEndian<qint32>(in + 8);
+        change.movesAfter = qFromLittleEndian<qint32>(in + 12);
+        delta.agents.append(change);
+    }
+    return true;
+}
+
+bool NetworkSession::parseAddress(const QString& text, QString& address, quint16& port) {
+    const QString trimmed = text.trimmed();
+    const int colon = trimmed.lastIndexOf(':');
+    address = (colon < 0) ? trimmed : trimmed.left(colon);
+    if (address.isEmpty()) address = "127.0.0.1";
+
+    port = DefaultPort;
+    if (colon >= 0) {
+        bool ok = false;
+        const uint value = trimmed.mid(colon + 1).toUInt(&ok);
+        if (!ok || value == 0 || value > 65535) return false;
+        port = quint16(value);
+    }
+    return true;
+}
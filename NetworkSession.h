@@ -0,0 +1,111 @@
+// NetworkSession.h - TCP host/client link for two-player network matches
+#ifndef NETWORKSESSION_H
+#define NETWORKSESSION_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include "GameHistory.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+// The host runs the authoritative GamePage and is always player 1; the client
+// is player 2. Clients only send what they clicked (Place / Action); the host
+// answers with full snapshots while placing and compact deltas during battle.
+// In lockstep mode both sides send only their own actions (12 bytes each) and
+// check the sender's state checksum after applying them.
+//
+// Wire format: [quint32 length][quint8 type][payload], little endian, where
+// length counts the type byte plus the payload. Cell indices are qint32:
+// generated maps go up to 4,000,000 cells (see MapGenerator.h).
+class NetworkSession : public QObject {
+    Q_OBJECT
+
+public:
+    enum Role {
+        Offline,
+        Host,
+        Client
+    };
+
+    enum MessageType : quint8 {
+        Hello = 1,      // client -> host: player name
+        Welcome,        // host -> client: player name
+        Snapshot,       // host -> client: GameSnapshot blob
+        Action,         // client -> host: from cell, to cell
+        Place,          // client -> host: cell index, card name
+        Delta,          // host -> client: encoded GameDelta
+        Seat,           // dedicated server -> client: player index, sent before Welcome
+        LockstepStart,  // host -> client: RNG seed; follows a battle snapshot
+        LockstepAction, // either way: from cell, to cell, checksum after the action
+        Resync          // client -> host: checksum mismatch, please resend the state
+    };
+
+    static constexpr quint16 DefaultPort = 45454;
+
+    explicit NetworkSession(QObject* parent = nullptr);
+    ~NetworkSession();
+
+    Role role() const { return m_role; }
+    bool isConnected() const;
+
+    bool host(quint16 port = DefaultPort);
+    void join(const QString& address, quint16 port = DefaultPort);
+    bool adoptDescriptor(qintptr socketDescriptor);   // Host side of an accepted connection
+    void close();
+    void closeGracefully();   // Flushes pending messages before disconnecting
+
+    // Outgoing messages
+    void sendHello(const QString& playerName);
+    void sendWelcome(const QString& playerName);
+    void sendSnapshot(const QByteArray& blob);
+    void sendAction(int fromCell, int toCell);
+    void sendPlace(const QString& cardName, int cellIndex);
+    void sendDelta(const GameDelta& delta);
+    void sendSeat(int playerIndex);
+    void sendLockstepStart(quint32 seed);
+    void sendLockstepAction(int fromCell, int toCell, quint32 checksum);
+    void sendResync();
+
+    // Delta wire encoding: only the "after" half is sent, as qint32 values
+    // (16 bytes per agent), so no roster or map size can truncate them
+    static QByteArray encodeDelta(const GameDelta& delta);
+    static bool decodeDelta(const QByteArray& payload, GameDelta& delta);
+
+    // Parses "host", "host:port" or ":port"
+    static bool parseAddress(const QString& text, QString& address, quint16& port);
+
+signals:
+    void connected();
+    void disconnected();
+    void errorOccurred(const QString& message);
+
+    void helloReceived(const QString& playerName);
+    void welcomeReceived(const QString& playerName);
+    void snapshotReceived(const QByteArray& blob);
+    void actionReceived(int fromCell, int toCell);
+    void placeReceived(const QString& cardName, int cellIndex);
+    void deltaReceived(const GameDelta& delta);
+    void seatReceived(int playerIndex);
+    void lockstepStartReceived(quint32 seed);
+    void lockstepActionReceived(int fromCell, int toCell, quint32 checksum);
+    void resyncRequested();
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onSocketDisconnected();
+
+private:
+    void attachSocket(QTcpSocket* socket);
+    void send(MessageType type, const QByteArray& payload);
+    void dispatch(MessageType type, const QByteArray& payload);
+
+    Role m_role = Offline;
+    QTcpServer* m_server = nullptr;
+    QTcpSocket* m_socket = nullptr;
+    QByteArray m_buffer;
+};
+
+#endif // NETWORKSESSION_H
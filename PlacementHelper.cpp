@@ -1,6 +1,6 @@
 // PlacementHelper.cpp - Implementation of PlacementHelper
 #include "PlacementHelper.h"
-#include <QDebug>
+#include "Log.h"
 
 PlacementHelper::PlacementHelper(QObject* parent) : QObject(parent) {
 }
@@ -15,8 +15,8 @@ void PlacementHelper::showPlacementZonesForAgentType(AgentType type, const QList
     
     Agent::showPlacementZonesForType(type, cells);
     
-    qDebug() << "Showing placement zones for agent type:" << type;
-    qDebug() << "Placement rules:" << Agent::getPlacementRules(type);
+    TM_LOG_DEBUG("Showing placement zones for agent type: %1", type);
+    TM_LOG_DEBUG("Placement rules: %1", Agent::getPlacementRules(type));
 }
 
 void PlacementHelper::showPlacementZonesForAgent(Agent* agent, const QList<Cell*>& cells) {
@@ -31,7 +31,7 @@ void PlacementHelper::showPlacementZonesForAgent(Agent* agent, const QList<Cell*
     
     agent->showPlacementZones(cells);
     
-    qDebug() << "Showing placement zones for agent:" << agent->getName();
+    TM_LOG_DEBUG("Showing placement zones for agent: %1", agent->getName());
 }
 
 void PlacementHelper::hideAllPlacementZones(const QList<Cell*>& cells) {
@@ -40,7 +40,7 @@ void PlacementHelper::hideAllPlacementZones(const QList<Cell*>& cells) {
     Agent::hidePlacementZones(cells);
     m_isShowingZones = false;
     
-    qDebug() << "Hiding all placement zones";
+    TM_LOG_DEBUG("Hiding all placement zones");
 }
 
 bool PlacementHelper::validatePlacement(Agent* agent, Cell* targetCell, QString& errorMessage) {
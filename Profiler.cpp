@@ -0,0 +1,152 @@
+// Profiler.cpp - Implementation of Profiler
+#include "Profiler.h"
+
+#ifdef TM_PROFILING
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Counted from every thread, so kept outside the (GUI thread only) Profiler
+std::atomic<qint64> g_allocations{0};
+
+}
+
+// Counting allocator: plain malloc/free underneath. The array, nothrow and
+// sized forms all funnel into these two by default.
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+qint64 Profiler::counterValue(Counter counter) const {
+    if (counter == Allocations) {
+        return g_allocations.load(std::memory_order_relaxed);
+    }
+    return m_counters[counter];
+}
+
+void Profiler::beginFrame() {
+    // Nested clicks (a handler triggering another) belong to the outer one
+    if (m_depth++ > 0) return;
+
+    m_current = Frame();
+    for (int i = 0; i < CounterCount; ++i) {
+        m_frameStart[i] = counterValue(Counter(i));
+    }
+    m_frameTimer.start();
+}
+
+void Profiler::endFrame() {
+    if (--m_depth > 0) return;
+
+    m_current.totalNs = m_frameTimer.nsecsElapsed();
+    for (int i = 0; i < CounterCount; ++i) {
+        m_frameEnd[i] = counterValue(Counter(i));
+        m_current.counters[i] = m_frameEnd[i] - m_frameStart[i];
+    }
+
+    const int slot = m_frameCount % HistorySize;
+    if (m_totalHistory.size() < HistorySize) {
+        m_totalHistory.append(m_current.totalNs);
+        for (int i = 0; i < SectionCount; ++i) m_sectionHistory[i].append(m_current.sectionNs[i]);
+    } else {
+        m_totalHistory[slot] = m_current.totalNs;
+        for (int i = 0; i < SectionCount; ++i) m_sectionHistory[i][slot] = m_current.sectionNs[i];
+    }
+
+    m_lastFrame = m_current;
+    ++m_frameCount;
+}
+
+void Profiler::addTime(Section section, qint64 ns) {
+    if (m_depth > 0) m_current.sectionNs[section] += ns;
+}
+
+void Profiler::add(Counter counter, qint64 amount) {
+    m_counters[counter] += amount;
+}
+
+void Profiler::addPaint(const Paint& paint) {
+    if (m_paintHistory.size() < HistorySize) {
+        m_paintHistory.append(paint);
+    } else {
+        m_paintHistory[m_paintCount % HistorySize] = paint;
+    }
+    m_lastPaint = paint;
+    ++m_paintCount;
+}
+
+qint64 Profiler::sinceLastFrame(Counter counter) const {
+    return counterValue(counter) - m_frameEnd[counter];
+}
+
+qint64 Profiler::percentile(const QVector<qint64>& samples, double fraction) {
+    if (samples.isEmpty()) return 0;
+    QVector<qint64> sorted = samples;
+    const int index = qBound(0, int(fraction * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+qint64 Profiler::totalPercentile(double fraction) const {
+    return percentile(m_totalHistory, fraction);
+}
+
+qint64 Profiler::sectionPercentile(Section section, double fraction) const {
+    return percentile(m_sectionHistory[section], fraction);
+}
+
+qint64 Profiler::paintPercentile(qint64 Paint::*field, double fraction) const {
+    QVector<qint64> samples;
+    samples.reserve(m_paintHistory.size());
+    for (const Paint& paint : m_paintHistory) samples.append(paint.*field);
+    return percentile(samples, fraction);
+}
+
+const char* Profiler::sectionName(Section section) {
+    switch (section) {
+    case ReachableBfs: return "reachable BFS";
+    case RangeBfs: return "range BFS";
+    case DistanceBfs: return "distance BFS";
+    case Highlight: return "highlight";
+    case ClearHighlights: return "clear highlights";
+    case Action: return "action";
+    case SectionCount: break;
+    }
+    return "";
+}
+
+const char* Profiler::counterName(Counter counter) {
+    switch (counter) {
+    case BfsNodes: return "BFS nodes";
+    case CellsRepainted: return "cells repainted";
+    case AgentsRepainted: return "agents repainted";
+    case BrushChanges: return "brush changes";
+    case ItemsCreated: return "items created";
+    case Allocations: return "allocations";
+    case CounterCount: break;
+    }
+    return "";
+}
+
+#endif // TM_PROFILING
@@ -0,0 +1,132 @@
+// Profiler.h - Scoped timers and counters for the click hot path
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+// Everything here is compiled only when TM_PROFILING is defined (debug builds,
+// or -DTM_PROFILING=ON). Otherwise the TM_PROFILE_* macros expand to nothing
+// and no timer, counter or allocation hook is left in the binary.
+//
+// A "frame" is one handled click: GamePage::onCellInteraction opens it, and
+// everything timed or counted until it returns is that click's breakdown.
+// A "paint" is one paint event of the game view's viewport, recorded by the
+// overlay while it is shown (see ProfilerOverlay).
+
+#ifdef TM_PROFILING
+
+class Profiler {
+public:
+    enum Section {
+        ReachableBfs,       // getReachableCells
+        RangeBfs,           // getCellsInRange
+        DistanceBfs,        // getBFSDistance
+        Highlight,          // highlight*Cells / highlightAttackableEnemies
+        ClearHighlights,    // clearAllHighlights
+        Action,             // performAction
+        SectionCount
+    };
+
+    enum Counter {
+        BfsNodes,           // Cells taken off a BFS queue
+        CellsRepainted,     // Cell::paint calls
+        AgentsRepainted,    // Agent::paint calls
+        BrushChanges,       // Brush or pen changes on cells and agents
+        ItemsCreated,       // Cells and Agents constructed
+        Allocations,        // operator new calls, all threads
+        CounterCount
+    };
+
+    struct Frame {
+        qint64 totalNs = 0;
+        qint64 sectionNs[SectionCount] = {};
+        qint64 counters[CounterCount] = {};
+    };
+
+    struct Paint {
+        qint64 ns = 0;
+        qint64 items = 0;           // Cells and agents painted
+        qint64 exposedPixels = 0;   // Area of the exposed region
+        qint64 rects = 0;           // Rectangles in the exposed region
+    };
+
+    static Profiler& instance();
+
+    void beginFrame();
+    void endFrame();
+    void addTime(Section section, qint64 ns);
+    void add(Counter counter, qint64 amount = 1);
+    void addPaint(const Paint& paint);
+
+    // Read by the overlay
+    int frameCount() const { return m_frameCount; }
+    const Frame& lastFrame() const { return m_lastFrame; }
+    qint64 sinceLastFrame(Counter counter) const;
+    qint64 totalPercentile(double fraction) const;
+    qint64 sectionPercentile(Section section, double fraction) const;
+    qint64 counterValue(Counter counter) const;
+
+    int paintCount() const { return m_paintCount; }
+    const Paint& lastPaint() const { return m_lastPaint; }
+    qint64 paintPercentile(qint64 Paint::*field, double fraction) const;
+
+    static const char* sectionName(Section section);
+    static const char* counterName(Counter counter);
+
+private:
+    Profiler() = default;
+    static qint64 percentile(const QVector<qint64>& samples, double fraction);
+
+    static const int HistorySize = 256;   // Clicks (and paints) the percentiles cover
+
+    int m_depth = 0;
+    QElapsedTimer m_frameTimer;
+    qint64 m_counters[CounterCount] = {};
+    qint64 m_frameStart[CounterCount] = {};
+    qint64 m_frameEnd[CounterCount] = {};
+    Frame m_current;
+    Frame m_lastFrame;
+    int m_frameCount = 0;
+
+    // Ring buffers of recent frames for the rolling percentiles
+    QVector<qint64> m_totalHistory;
+    QVector<qint64> m_sectionHistory[SectionCount];
+
+    Paint m_lastPaint;
+    int m_paintCount = 0;
+    QVector<Paint> m_paintHistory;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(Profiler::Section section) : m_section(section) { m_timer.start(); }
+    ~ProfileScope() { Profiler::instance().addTime(m_section, m_timer.nsecsElapsed()); }
+
+private:
+    Profiler::Section m_section;
+    QElapsedTimer m_timer;
+};
+
+class ProfileFrame {
+public:
+    ProfileFrame() { Profiler::instance().beginFrame(); }
+    ~ProfileFrame() { Profiler::instance().endFrame(); }
+};
+
+#define TM_PROFILE_CONCAT_(a, b) a##b
+#define TM_PROFILE_CONCAT(a, b) TM_PROFILE_CONCAT_(a, b)
+#define TM_PROFILE_FRAME() ProfileFrame TM_PROFILE_CONCAT(tmProfileFrame, __LINE__)
+#define TM_PROFILE_SCOPE(section) ProfileScope TM_PROFILE_CONCAT(tmProfileScope, __LINE__)(Profiler::section)
+#define TM_PROFILE_COUNT(counter, amount) Profiler::instance().add(Profiler::counter, (amount))
+
+#else
+
+#define TM_PROFILE_FRAME() ((void)0)
+#define TM_PROFILE_SCOPE(section) ((void)0)
+#define TM_PROFILE_COUNT(counter, amount) ((void)0)
+
+#endif // TM_PROFILING
+
+#endif // PROFILER_H
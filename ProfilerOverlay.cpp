@@ -0,0 +1,200 @@
+// ProfilerOverlay.cpp - Implementation of ProfilerOverlay
+#include "ProfilerOverlay.h"
+
+#ifdef TM_PROFILING
+
+#include <QCoreApplication>
+#include <QFontDatabase>
+#include <QGraphicsItem>
+#include <QPaintEvent>
+#include <QTimer>
+#include "Profiler.h"
+
+namespace {
+
+QString ms(qint64 ns) {
+    return QString::number(ns / 1e6, 'f', 3);
+}
+
+const char* updateModeName(QGraphicsView::ViewportUpdateMode mode) {
+    switch (mode) {
+    case QGraphicsView::FullViewportUpdate: return "full";
+    case QGraphicsView::MinimalViewportUpdate: return "minimal";
+    case QGraphicsView::SmartViewportUpdate: return "smart";
+    case QGraphicsView::BoundingRectViewportUpdate: return "bounding rect";
+    case QGraphicsView::NoViewportUpdate: return "none";
+    }
+    return "";
+}
+
+const char* cacheSettingName(ProfilerOverlay::CacheSetting setting) {
+    switch (setting) {
+    case ProfilerOverlay::NoCache: return "none";
+    case ProfilerOverlay::BackgroundCache: return "background";
+    case ProfilerOverlay::ItemCache: return "background + items";
+    case ProfilerOverlay::CacheSettingCount: break;
+    }
+    return "";
+}
+
+qint64 itemsPainted() {
+    const Profiler& profiler = Profiler::instance();
+    return profiler.counterValue(Profiler::CellsRepainted) + profiler.counterValue(Profiler::AgentsRepainted);
+}
+
+}
+
+ProfilerOverlay::ProfilerOverlay(QGraphicsView* view) : QLabel(view), m_view(view) {
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setStyleSheet("background-color: rgba(0, 0, 0, 180); color: #7CFC00; padding: 6px;");
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    move(8, 8);
+    hide();
+
+    // The overlay is a child of the view, not of its viewport, so its own
+    // paints never show up here
+    m_view->viewport()->installEventFilter(this);
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(250);
+    connect(m_timer, &QTimer::timeout, this, [this]() { refresh(); });
+}
+
+void ProfilerOverlay::toggle() {
+    if (isVisible()) {
+        m_timer->stop();
+        hide();
+    } else {
+        refresh();
+        show();
+        raise();
+        m_timer->start();
+    }
+}
+
+void ProfilerOverlay::cycleUpdateMode() {
+    // NoViewportUpdate is left out: the board would stop redrawing entirely
+    static const QGraphicsView::ViewportUpdateMode modes[] = {
+        QGraphicsView::MinimalViewportUpdate,
+        QGraphicsView::SmartViewportUpdate,
+        QGraphicsView::BoundingRectViewportUpdate,
+        QGraphicsView::FullViewportUpdate
+    };
+    const int count = int(sizeof(modes) / sizeof(modes[0]));
+
+    int next = 0;
+    for (int i = 0; i < count; ++i) {
+        if (modes[i] == m_view->viewportUpdateMode()) next = (i + 1) % count;
+    }
+    m_view->setViewportUpdateMode(modes[next]);
+    m_view->viewport()->update();
+    if (isVisible()) refresh();
+}
+
+void ProfilerOverlay::cycleCacheSetting() {
+    m_cacheSetting = CacheSetting((m_cacheSetting + 1) % CacheSettingCount);
+    applyCacheSetting();
+    if (isVisible()) refresh();
+}
+
+void ProfilerOverlay::applyCacheSetting() {
+    m_view->setCacheMode(m_cacheSetting == NoCache ? QGraphicsView::CacheNone : QGraphicsView::CacheBackground);
+    m_view->resetCachedContent();
+
+    // Applies to the items on the board now; after loading another map,
+    // cycle round again to cover the new ones
+    if (QGraphicsScene* scene = m_view->scene()) {
+        const QGraphicsItem::CacheMode itemMode = m_cacheSetting == ItemCache
+            ? QGraphicsItem::DeviceCoordinateCache : QGraphicsItem::NoCache;
+        for (QGraphicsItem* item : scene->items()) {
+            item->setCacheMode(itemMode);
+        }
+    }
+    m_view->viewport()->update();
+}
+
+bool ProfilerOverlay::eventFilter(QObject* watched, QEvent* event) {
+    if (event->type() != QEvent::Paint || m_inPaint || !isVisible()) {
+        return QLabel::eventFilter(watched, event);
+    }
+    recordPaint(watched, event);
+    return true;
+}
+
+void ProfilerOverlay::recordPaint(QObject* watched, QEvent* event) {
+    Profiler::Paint paint;
+    for (const QRect& rect : static_cast<QPaintEvent*>(event)->region()) {
+        paint.exposedPixels += qint64(rect.width()) * rect.height();
+        ++paint.rects;
+    }
+
+    // Deliver the paint ourselves (the nested call skips the filter) so the
+    // time covers the whole paint, as TracePaintFilter does
+    const qint64 itemsBefore = itemsPainted();
+    QElapsedTimer timer;
+    timer.start();
+    m_inPaint = true;
+    QCoreApplication::sendEvent(watched, event);
+    m_inPaint = false;
+    paint.ns = timer.nsecsElapsed();
+    paint.items = itemsPainted() - itemsBefore;
+
+    Profiler::instance().addPaint(paint);
+}
+
+void ProfilerOverlay::refresh() {
+    const Profiler& profiler = Profiler::instance();
+    const Profiler::Frame& frame = profiler.lastFrame();
+
+    QStringList lines;
+    lines << QString("click #%1  %2 ms   p50 %3  p90 %4  p99 %5")
+             .arg(profiler.frameCount())
+             .arg(ms(frame.totalNs))
+             .arg(ms(profiler.totalPercentile(0.50)))
+             .arg(ms(profiler.totalPercentile(0.90)))
+             .arg(ms(profiler.totalPercentile(0.99)));
+
+    // Inclusive times: a BFS run by a highlight counts in both
+    for (int i = 0; i < Profiler::SectionCount; ++i) {
+        const Profiler::Section section = Profiler::Section(i);
+        lines << QString("  %1 %2 ms   p50 %3  p90 %4")
+                 .arg(QString(Profiler::sectionName(section)), -17)
+                 .arg(ms(frame.sectionNs[i]), 7)
+                 .arg(ms(profiler.sectionPercentile(section, 0.50)))
+                 .arg(ms(profiler.sectionPercentile(section, 0.90)));
+    }
+
+    for (int i = 0; i < Profiler::CounterCount; ++i) {
+        const Profiler::Counter counter = Profiler::Counter(i);
+        lines << QString("  %1 %2").arg(QString(Profiler::counterName(counter)), -17).arg(frame.counters[i], 7);
+    }
+
+    // The scene repaints after the click handler returns
+    lines << QString("  repainted since  %1 cells").arg(profiler.sinceLastFrame(Profiler::CellsRepainted));
+
+    // Paints of the view, counted only while the overlay is shown
+    const Profiler::Paint& paint = profiler.lastPaint();
+    const qint64 viewportPixels = qMax<qint64>(1, qint64(m_view->viewport()->width()) * m_view->viewport()->height());
+    lines << QString("paint #%1  %2 ms   p50 %3  p90 %4  p99 %5")
+             .arg(profiler.paintCount())
+             .arg(ms(paint.ns))
+             .arg(ms(profiler.paintPercentile(&Profiler::Paint::ns, 0.50)))
+             .arg(ms(profiler.paintPercentile(&Profiler::Paint::ns, 0.90)))
+             .arg(ms(profiler.paintPercentile(&Profiler::Paint::ns, 0.99)));
+    lines << QString("  %1 %2   p90 %3")
+             .arg(QString("items painted"), -17)
+             .arg(paint.items, 7)
+             .arg(profiler.paintPercentile(&Profiler::Paint::items, 0.90));
+    lines << QString("  %1 %2%   %3 rects   p90 %4%")
+             .arg(QString("exposed area"), -17)
+             .arg(paint.exposedPixels * 100 / viewportPixels, 6)
+             .arg(paint.rects)
+             .arg(profiler.paintPercentile(&Profiler::Paint::exposedPixels, 0.90) * 100 / viewportPixels);
+    lines << QString("  F4 update mode   %1").arg(QString(updateModeName(m_view->viewportUpdateMode())));
+    lines << QString("  F5 cache         %1").arg(QString(cacheSettingName(m_cacheSetting)));
+
+    setText(lines.join('\n'));
+    adjustSize();
+}
+
+#endif // TM_PROFILING
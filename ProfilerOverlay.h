@@ -0,0 +1,50 @@
+// ProfilerOverlay.h - Debug overlay showing Profiler data on the game view
+#ifndef PROFILEROVERLAY_H
+#define PROFILEROVERLAY_H
+
+#ifdef TM_PROFILING
+
+#include <QElapsedTimer>
+#include <QGraphicsView>
+#include <QLabel>
+
+class QTimer;
+
+// Sits in the top-left corner of the game view and refreshes a few times a
+// second while visible: the last click's breakdown, rolling percentiles, and
+// the view's paints (time, items painted, exposed area).
+//
+// The view's update and cache modes can be switched while it runs, so the
+// same interaction can be compared across them.
+class ProfilerOverlay : public QLabel {
+public:
+    enum CacheSetting {
+        NoCache,            // Nothing cached
+        BackgroundCache,    // QGraphicsView::CacheBackground
+        ItemCache,          // Background plus DeviceCoordinateCache on every item
+        CacheSettingCount
+    };
+
+    explicit ProfilerOverlay(QGraphicsView* view);
+
+    void toggle();
+    void cycleUpdateMode();
+    void cycleCacheSetting();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    void refresh();
+    void recordPaint(QObject* watched, QEvent* event);
+    void applyCacheSetting();
+
+    QGraphicsView* m_view;
+    QTimer* m_timer;
+    CacheSetting m_cacheSetting = NoCache;
+    bool m_inPaint = false;
+};
+
+#endif // TM_PROFILING
+
+#endif // PROFILEROVERLAY_H
@@ -0,0 +1,112 @@
+// TerrainLayer.cpp - Implementation of TerrainLayer
+#include "TerrainLayer.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+#include <cmath>
+#include "BoardNavigator.h"
+#include "Cell.h"
+#include "TraceRecorder.h"
+
+namespace {
+
+const int LevelsPerDoubling = 4;
+
+quint64 tileKey(int level, int tileX, int tileY) {
+    return (quint64(quint16(level)) << 48) | (quint64(quint32(tileY) & 0xffffff) << 24) | (quint32(tileX) & 0xffffff);
+}
+
+}
+
+TerrainLayer::TerrainLayer(const QVector<Cell*>& cells, QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_cells(cells), m_tiles(CacheKilobytes)
+{
+    for (Cell* cell : m_cells) {
+        m_bounds |= cell->boundingRect();
+    }
+
+    m_bucketColumns = qMax(1, qCeil(m_bounds.width() / BucketSize));
+    m_bucketRows = qMax(1, qCeil(m_bounds.height() / BucketSize));
+    m_buckets.resize(m_bucketColumns * m_bucketRows);
+    for (int i = 0; i < m_cells.size(); ++i) {
+        const QPointF offset = m_cells[i]->getCenter() - m_bounds.topLeft();
+        const int column = qBound(0, int(offset.x() / BucketSize), m_bucketColumns - 1);
+        const int row = qBound(0, int(offset.y() / BucketSize), m_bucketRows - 1);
+        m_buckets[row * m_bucketColumns + column].append(i);
+    }
+
+    setZValue(-1);
+    setAcceptedMouseButtons(Qt::NoButton);   // Clicks go to the cells
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);   // For exposedRect
+}
+
+QRectF TerrainLayer::boundingRect() const {
+    return m_bounds;
+}
+
+void TerrainLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    const QRectF exposed = option->exposedRect & m_bounds;
+    if (exposed.isEmpty()) return;
+
+    const double viewScale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    const int level = qRound(std::log2(qMax(viewScale, 1e-3)) * LevelsPerDoubling);
+    const double span = TileSize / std::exp2(double(level) / LevelsPerDoubling);   // Scene units per tile
+
+    const int firstX = int((exposed.left() - m_bounds.left()) / span);
+    const int lastX = int((exposed.right() - m_bounds.left()) / span);
+    const int firstY = int((exposed.top() - m_bounds.top()) / span);
+    const int lastY = int((exposed.bottom() - m_bounds.top()) / span);
+    for (int tileY = firstY; tileY <= lastY; ++tileY) {
+        for (int tileX = firstX; tileX <= lastX; ++tileX) {
+            const QRectF target(m_bounds.left() + tileX * span, m_bounds.top() + tileY * span, span, span);
+            if (const QPixmap* pixmap = tile(level, tileX, tileY)) {
+                painter->drawPixmap(target, *pixmap, QRectF(0, 0, TileSize, TileSize));
+            }
+        }
+    }
+}
+
+QPixmap* TerrainLayer::tile(int level, int tileX, int tileY) {
+    const quint64 key = tileKey(level, tileX, tileY);
+    if (QPixmap* cached = m_tiles.object(key)) return cached;
+
+    const double scale = std::exp2(double(level) / LevelsPerDoubling);
+    const double span = TileSize / scale;
+    const QRectF area(m_bounds.left() + tileX * span, m_bounds.top() + tileY * span, span, span);
+    QPixmap* pixmap = renderTile(scale, area);
+    m_tiles.insert(key, pixmap, TileSize * TileSize * 4 / 1024);
+    return m_tiles.object(key);
+}
+
+QPixmap* TerrainLayer::renderTile(double scale, const QRectF& area) const {
+    TM_TRACE_SPAN("render terrain tile", "render");
+    QPixmap* pixmap = new QPixmap(TileSize, TileSize);
+    pixmap->fill(Qt::transparent);
+
+    QPainter painter(pixmap);
+    painter.scale(scale, scale);
+    painter.translate(-area.topLeft());
+    // The same look Cell::paint gives a plain cell at this zoom
+    painter.setPen(scale >= BoardNavigator::DetailScale ? QPen(Qt::gray) : QPen(Qt::NoPen));
+
+    // Cells are smaller than a bucket, so one bucket of margin finds every
+    // cell reaching into the tile
+    const QPointF from = area.topLeft() - m_bounds.topLeft();
+    const QPointF to = area.bottomRight() - m_bounds.topLeft();
+    const int firstColumn = qMax(0, int(from.x() / BucketSize) - 1);
+    const int lastColumn = qMin(m_bucketColumns - 1, int(to.x() / BucketSize) + 1);
+    const int firstRow = qMax(0, int(from.y() / BucketSize) - 1);
+    const int lastRow = qMin(m_bucketRows - 1, int(to.y() / BucketSize) + 1);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            for (int index : m_buckets[row * m_bucketColumns + column]) {
+                const Cell* cell = m_cells[index];
+                if (!cell->boundingRect().intersects(area)) continue;
+                painter.setBrush(Cell::terrainBrush(cell->getType()));
+                painter.drawPolygon(cell->polygon());
+            }
+        }
+    }
+    return pixmap;
+}
@@ -0,0 +1,48 @@
+// TerrainLayer.h - The board's terrain, pre-rendered into cached tiles
+#ifndef TERRAINLAYER_H
+#define TERRAINLAYER_H
+
+#include <QCache>
+#include <QGraphicsItem>
+#include <QPixmap>
+#include <QVector>
+
+class Cell;
+
+// One item under every cell that draws the terrain -- fills, and outlines
+// when zoomed in -- from pixmap tiles. Terrain never changes during a match,
+// so each tile is rendered once per zoom level and then only copied; cells
+// paint themselves only while something differs from plain terrain
+// (highlights, selection, fog; see Cell::paint). A highlight change then
+// repaints its cell's rect: a few pixmap copies plus that one polygon.
+//
+// Zoom levels are quarter powers of two, so zooming renders at most one new
+// set of tiles per step, and tiles for several levels stay in the cache.
+class TerrainLayer : public QGraphicsItem {
+public:
+    static const int TileSize = 256;           // Device pixels
+    static const int CacheKilobytes = 65536;   // About 256 tiles
+
+    explicit TerrainLayer(const QVector<Cell*>& cells, QGraphicsItem* parent = nullptr);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private:
+    QPixmap* tile(int level, int tileX, int tileY);
+    QPixmap* renderTile(double scale, const QRectF& area) const;
+
+    QVector<Cell*> m_cells;
+    QRectF m_bounds;
+
+    // Cells by the square of the board their centre lies in, for finding
+    // the cells a tile covers
+    static constexpr double BucketSize = 256;   // Scene units, several hexes
+    int m_bucketColumns = 0;
+    int m_bucketRows = 0;
+    QVector<QVector<int>> m_buckets;
+
+    QCache<quint64, QPixmap> m_tiles;   // Key: level, tile row, tile column
+};
+
+#endif // TERRAINLAYER_H
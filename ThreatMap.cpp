@@ -0,0 +1,164 @@
+// ThreatMap.cpp - Implementation of ThreatMap
+#include "ThreatMap.h"
+#include "GameRules.h"
+#include <algorithm>
+
+static bool dependsOn(const QVector<int>& explored, int cell) {
+    return cell >= 0 && std::binary_search(explored.begin(), explored.end(), cell);
+}
+
+void ThreatMap::reset(QSharedPointer<const HexBoard> board, bool lineOfSight) {
+    m_board = board;
+    m_lineOfSight = lineOfSight;
+    clear();
+}
+
+void ThreatMap::clear() {
+    const int cells = m_board ? m_board->cellCount() : 0;
+    m_agents.clear();
+    m_occupied.fill(0, cells);
+    for (int player = 0; player < 2; ++player) {
+        m_count[player].fill(0, cells);
+        m_damage[player].fill(0, cells);
+    }
+    m_changed.clear();
+    m_changedMark.fill(false, cells);
+
+    m_looked.fill(0, cells);
+    m_marked.fill(0, cells);
+    m_distance.fill(0, cells);
+    m_stamp = 0;
+}
+
+void ThreatMap::setAgent(int agentId, const ThreatSource& source) {
+    if (!m_board || agentId < 0) return;
+    if (agentId >= m_agents.size()) m_agents.resize(agentId + 1);
+
+    Footprint& footprint = m_agents[agentId];
+    if (footprint.source == source) return;
+
+    const int oldCell = footprint.source.cell;
+    apply(footprint, -1);
+    if (oldCell >= 0) --m_occupied[oldCell];
+    footprint.source = source;
+    if (source.cell >= 0) ++m_occupied[source.cell];
+    build(footprint);
+    apply(footprint, 1);
+
+    // Someone entered or left a cell: only the searches that read it can
+    // come out differently
+    if (oldCell == source.cell) return;
+    for (int id = 0; id < m_agents.size(); ++id) {
+        Footprint& other = m_agents[id];
+        if (id == agentId || other.source.cell < 0) continue;
+        if (dependsOn(other.explored, oldCell) || dependsOn(other.explored, source.cell)) {
+            apply(other, -1);
+            build(other);
+            apply(other, 1);
+        }
+    }
+}
+
+void ThreatMap::setAgentCount(int count) {
+    for (int id = m_agents.size() - 1; id >= count; --id) {
+        setAgent(id, ThreatSource());
+    }
+    if (m_agents.size() > count) m_agents.resize(qMax(0, count));
+}
+
+QVector<int> ThreatMap::takeChangedCells() {
+    QVector<int> changed;
+    changed.swap(m_changed);
+    for (int cell : changed) m_changedMark[cell] = false;
+    return changed;
+}
+
+int ThreatMap::nextStamp() {
+    if (++m_stamp <= 0) {
+        m_looked.fill(0);
+        m_marked.fill(0);
+        m_stamp = 1;
+    }
+    return m_stamp;
+}
+
+void ThreatMap::build(Footprint& footprint) {
+    footprint.cells.clear();
+    footprint.explored.clear();
+    const ThreatSource& source = footprint.source;
+    if (source.cell < 0) return;
+    const int stamp = nextStamp();
+
+    // Where the agent can stand, noting every cell whose occupancy the
+    // movement search reads
+    m_looked[source.cell] = stamp;
+    footprint.explored.append(source.cell);
+    GameRules::searchMoves(m_search, *m_board, source.type, source.cell, qMax(0, source.moves), [&](int cell) {
+        if (m_looked[cell] != stamp) {
+            m_looked[cell] = stamp;
+            footprint.explored.append(cell);
+        }
+        return m_occupied[cell] != 0;
+    });
+    std::sort(footprint.explored.begin(), footprint.explored.end());
+
+    m_stands.clear();
+    for (int cell : m_search.settled()) {
+        if (cell == source.cell || GameRules::canPlaceOn(source.type, m_board->terrain(cell))) {
+            m_stands.append(cell);
+        }
+    }
+
+    // What it can hit from there. The agent's own cell never counts.
+    if (m_lineOfSight) {
+        // Nothing beyond SightRange is ever visible, so nothing beyond it can be attacked
+        const int radius = qMin(source.attackRange, int(HexBoard::SightRange));
+        for (int stand : m_stands) {
+            m_board->cellsInSight(stand, radius, true, m_sight);
+            for (int cell : m_sight) {
+                if (m_marked[cell] == stamp || cell == source.cell) continue;
+                m_marked[cell] = stamp;
+                footprint.cells.append(cell);
+            }
+        }
+    } else {
+        // One search from every stand cell at once; range ignores terrain,
+        // as in RangeSearch
+        m_queue.clear();
+        for (int stand : m_stands) {
+            m_marked[stand] = stamp;
+            m_distance[stand] = 0;
+            m_queue.append(stand);
+        }
+        for (int head = 0; head < m_queue.size(); ++head) {
+            const int cell = m_queue[head];
+            if (cell != source.cell) footprint.cells.append(cell);
+            if (m_distance[cell] >= source.attackRange) continue;
+
+            for (const int* it = m_board->neighborsBegin(cell); it != m_board->neighborsEnd(cell); ++it) {
+                if (m_marked[*it] != stamp) {
+                    m_marked[*it] = stamp;
+                    m_distance[*it] = m_distance[cell] + 1;
+                    m_queue.append(*it);
+                }
+            }
+        }
+    }
+}
+
+void ThreatMap::apply(const Footprint& footprint, int sign) {
+    const int owner = footprint.source.owner;
+    const int damage = footprint.source.damage * sign;
+    for (int cell : footprint.cells) {
+        m_count[owner][cell] = quint8(m_count[owner][cell] + sign);
+        m_damage[owner][cell] += damage;
+        touch(cell);
+    }
+}
+
+void ThreatMap::touch(int cell) {
+    if (!m_changedMark[cell]) {
+        m_changedMark[cell] = true;
+        m_changed.append(cell);
+    }
+}
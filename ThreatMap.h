@@ -0,0 +1,87 @@
+// ThreatMap.h - Per-cell threat from each player's agents, updated as they change
+#ifndef THREATMAP_H
+#define THREATMAP_H
+
+#include <QSharedPointer>
+#include <QVector>
+#include "AgentType.h"
+#include "HexBoard.h"
+#include "MoveCosts.h"
+
+// What the threat map needs to know about one agent. cell -1 means the agent
+// doesn't count (dead, not placed, or hidden from whoever is asking).
+struct ThreatSource {
+    int owner = 0;
+    AgentType type = Grounded;
+    int cell = -1;
+    int moves = 0;          // Move budget for the turn being looked at
+    int damage = 0;
+    int attackRange = 0;
+
+    bool operator==(const ThreatSource& other) const {
+        return owner == other.owner && type == other.type && cell == other.cell && moves == other.moves
+               && damage == other.damage && attackRange == other.attackRange;
+    }
+    bool operator!=(const ThreatSource& other) const { return !(*this == other); }
+};
+
+// For each player and cell: how many of the player's agents could move and
+// then attack the cell, and how much damage they could deal together. An
+// agent's footprint is every cell within its attack range of a cell it can
+// reach (or of the cell it stands on); with line of sight, only the cells it
+// could see from there.
+//
+// Callers pass every agent to setAgent() whenever it may have changed; an
+// unchanged agent costs a comparison. A footprint is recomputed when its own
+// agent changes, or when another agent enters or leaves a cell its movement
+// search looked at. Nothing is ever rebuilt for the whole map.
+class ThreatMap {
+public:
+    ThreatMap() = default;
+
+    void reset(QSharedPointer<const HexBoard> board, bool lineOfSight);
+    void clear();   // No agents
+
+    void setAgent(int agentId, const ThreatSource& source);
+    void setAgentCount(int count);   // Drops the agents from count on
+
+    int threatCount(int playerIndex, int cell) const { return m_count[playerIndex][cell]; }
+    int threatDamage(int playerIndex, int cell) const { return m_damage[playerIndex][cell]; }
+
+    // Cells whose threat changed since the last call, for redrawing
+    QVector<int> takeChangedCells();
+
+private:
+    struct Footprint {
+        ThreatSource source;
+        QVector<int> cells;       // Threatened cells
+        QVector<int> explored;    // Cells whose occupancy the movement search read, sorted
+    };
+
+    void build(Footprint& footprint);
+    void apply(const Footprint& footprint, int sign);
+    void touch(int cell);
+    int nextStamp();
+
+    QSharedPointer<const HexBoard> m_board;
+    bool m_lineOfSight = false;
+    QVector<Footprint> m_agents;
+    QVector<quint8> m_occupied;     // Agents standing on each cell
+    QVector<quint8> m_count[2];
+    QVector<int> m_damage[2];
+
+    QVector<int> m_changed;
+    QVector<bool> m_changedMark;
+
+    // Scratch space for build(), reused so an update doesn't allocate
+    QVector<int> m_looked;          // Stamp: occupancy read by the movement search
+    QVector<int> m_marked;          // Stamp: already in the footprint
+    QVector<int> m_distance;
+    QVector<int> m_queue;
+    QVector<int> m_stands;
+    QVector<int> m_sight;
+    MoveSearch m_search;
+    int m_stamp = 0;
+};
+
+#endif // THREATMAP_H
@@ -0,0 +1,56 @@
+// ThreatOverlay.cpp - Implementation of ThreatOverlay
+#include "ThreatOverlay.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include "Cell.h"
+
+ThreatOverlay::ThreatOverlay(const QVector<Cell*>& cells, QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_cells(cells), m_count(cells.size(), 0), m_damage(cells.size(), 0)
+{
+    for (Cell* cell : m_cells) {
+        m_bounds |= cell->boundingRect();
+    }
+    setAcceptedMouseButtons(Qt::NoButton);   // Clicks go through to the cells
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);   // For exposedRect
+}
+
+void ThreatOverlay::setThreat(int cell, int count, int damage) {
+    if (cell < 0 || cell >= m_cells.size()) return;
+    const quint8 clamped = quint8(qMin(count, 255));
+    if (m_count[cell] == clamped && m_damage[cell] == damage) return;
+    m_count[cell] = clamped;
+    m_damage[cell] = damage;
+    update(m_cells[cell]->boundingRect());
+}
+
+void ThreatOverlay::clearThreats() {
+    m_count.fill(0);
+    m_damage.fill(0);
+    update();
+}
+
+QRectF ThreatOverlay::boundingRect() const {
+    return m_bounds;
+}
+
+void ThreatOverlay::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    painter->setPen(Qt::NoPen);
+    QFont font = painter->font();
+    font.setPointSize(8);
+    painter->setFont(font);
+
+    for (int i = 0; i < m_cells.size(); ++i) {
+        if (m_count[i] == 0) continue;
+        const QRectF rect = m_cells[i]->boundingRect();
+        if (!rect.intersects(option->exposedRect)) continue;
+
+        // One agent is a light tint, three or more nearly opaque
+        const int alpha = qMin(200, 40 + 60 * m_count[i]);
+        painter->setBrush(QColor(220, 30, 30, alpha));
+        painter->drawPolygon(m_cells[i]->polygon());
+        painter->setPen(Qt::black);
+        painter->drawText(rect, Qt::AlignCenter, QString::number(m_damage[i]));
+        painter->setPen(Qt::NoPen);
+    }
+}
@@ -0,0 +1,30 @@
+// ThreatOverlay.h - Heat map of enemy threat drawn over the board
+#ifndef THREATOVERLAY_H
+#define THREATOVERLAY_H
+
+#include <QGraphicsItem>
+#include <QVector>
+
+class Cell;
+
+// One item over every cell, below the agents: threatened cells are tinted
+// red, darker the more enemy agents reach them, with the damage they could
+// deal written in the middle. setThreat() repaints just that cell's rect.
+class ThreatOverlay : public QGraphicsItem {
+public:
+    explicit ThreatOverlay(const QVector<Cell*>& cells, QGraphicsItem* parent = nullptr);
+
+    void setThreat(int cell, int count, int damage);
+    void clearThreats();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private:
+    QVector<Cell*> m_cells;
+    QVector<quint8> m_count;
+    QVector<int> m_damage;
+    QRectF m_bounds;
+};
+
+#endif // THREATOVERLAY_H
@@ -0,0 +1,107 @@
+// TraceRecorder.cpp - Implementation of TraceRecorder
+#include "TraceRecorder.h"
+#include "Log.h"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+
+std::atomic<bool> TraceRecorder::s_recording{false};
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::start() {
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+    m_events.reserve(4096);
+    m_dropped = 0;
+    m_clock.start();
+    s_recording.store(true, std::memory_order_relaxed);
+}
+
+int TraceRecorder::currentThreadId() {
+    // Small stable ids per thread; called with m_mutex held
+    static thread_local int threadId = 0;
+    if (threadId == 0) {
+        threadId = m_nextThreadId++;
+        QThread* thread = QThread::currentThread();
+        QString name = thread->objectName();
+        if (name.isEmpty()) {
+            const bool mainThread = QCoreApplication::instance()
+                                    && thread == QCoreApplication::instance()->thread();
+            name = mainThread ? QString("main") : QString("thread %1").arg(threadId);
+        }
+        m_threadNames.insert(threadId, name);
+    }
+    return threadId;
+}
+
+void TraceRecorder::addSpan(const char* name, const char* category, qint64 startNs) {
+    const qint64 endNs = now();
+    QMutexLocker locker(&m_mutex);
+    if (!isRecording()) return;
+    if (m_events.size() >= MaxEvents) {
+        ++m_dropped;
+        return;
+    }
+    m_events.append({name, category, startNs, endNs - startNs, currentThreadId()});
+}
+
+bool TraceRecorder::stop(const QString& path) {
+    QMutexLocker locker(&m_mutex);
+    s_recording.store(false, std::memory_order_relaxed);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        TM_LOG_WARNING("Cannot write trace: %1 %2", path, file.errorString());
+        m_events.clear();
+        return false;
+    }
+
+    // Timestamps are microseconds; keep the nanoseconds as decimals
+    QTextStream out(&file);
+    const qint64 pid = QCoreApplication::applicationPid();
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto it = m_threadNames.constBegin(); it != m_threadNames.constEnd(); ++it) {
+        out << (first ? "" : ",\n")
+            << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << it.key()
+            << ",\"args\":{\"name\":\"" << it.value() << "\"}}";
+        first = false;
+    }
+    for (const Event& event : m_events) {
+        out << (first ? "" : ",\n")
+            << "{\"ph\":\"X\",\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+            << "\",\"pid\":" << pid << ",\"tid\":" << event.threadId
+            << ",\"ts\":" << QString::number(event.startNs / 1000.0, 'f', 3)
+            << ",\"dur\":" << QString::number(event.durationNs / 1000.0, 'f', 3) << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+
+    if (m_dropped > 0) {
+        TM_LOG_WARNING("Trace buffer full, %1 spans dropped", m_dropped);
+    }
+    TM_LOG_INFO("Wrote %1 trace events to %2", m_events.size(), path);
+    m_events.clear();
+    return true;
+}
+
+bool TracePaintFilter::eventFilter(QObject* watched, QEvent* event) {
+    if (event->type() != QEvent::Paint || m_inPaint || !TraceRecorder::isRecording()) {
+        return QObject::eventFilter(watched, event);
+    }
+
+    // Deliver the paint ourselves (the nested call skips this branch) so the
+    // span covers the whole paint, not just the time to reach it
+    TM_TRACE_SPAN("paint", "render");
+    m_inPaint = true;
+    QCoreApplication::sendEvent(watched, event);
+    m_inPaint = false;
+    return true;
+}
@@ -0,0 +1,84 @@
+// TraceRecorder.h - Chrome trace-event recording of gameplay and rendering spans
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// Records named spans from any thread and writes them as Chrome trace-event
+// JSON ("X" complete events plus thread names), which chrome://tracing and
+// Perfetto open directly. Unlike Profiler this is always compiled in: while
+// not recording a span costs one atomic load, so it can be switched on in a
+// production session to capture a timeline for a bug report.
+class TraceRecorder {
+public:
+    static TraceRecorder& instance();
+    static bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+    void start();
+    bool stop(const QString& path);   // Writes the JSON file and drops the events
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+    void addSpan(const char* name, const char* category, qint64 startNs);
+
+private:
+    struct Event {
+        const char* name;       // String literals only, never copied
+        const char* category;
+        qint64 startNs;
+        qint64 durationNs;
+        int threadId;
+    };
+
+    TraceRecorder() = default;
+    int currentThreadId();
+
+    // Caps memory if recording is left on; later spans are dropped
+    static const int MaxEvents = 1000000;
+
+    static std::atomic<bool> s_recording;
+    QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<Event> m_events;
+    QHash<int, QString> m_threadNames;
+    int m_nextThreadId = 1;
+    int m_dropped = 0;
+};
+
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category)
+        : m_name(name), m_category(category),
+          m_start(TraceRecorder::isRecording() ? TraceRecorder::instance().now() : -1) {}
+    ~TraceSpan() {
+        if (m_start >= 0) TraceRecorder::instance().addSpan(m_name, m_category, m_start);
+    }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    qint64 m_start;
+};
+
+#define TM_TRACE_CONCAT_(a, b) a##b
+#define TM_TRACE_CONCAT(a, b) TM_TRACE_CONCAT_(a, b)
+#define TM_TRACE_SPAN(name, category) TraceSpan TM_TRACE_CONCAT(tmTraceSpan, __LINE__)(name, category)
+
+// Install on a QGraphicsView's viewport to get one span per paint event
+class TracePaintFilter : public QObject {
+public:
+    explicit TracePaintFilter(QObject* parent = nullptr) : QObject(parent) {}
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    bool m_inPaint = false;
+};
+
+#endif // TRACERECORDER_H
@@ -38,10 +38,14 @@ public:
     bool canMoveTo(Cell* target, class GamePage* gamePage) const;
     bool canBePlacedOn(Cell::CellType cellType) const;
     bool canMoveThrough(Cell::CellType cellType) const;
-    void moveTo(Cell* target, class GamePage* gamePage);
+    bool moveTo(Cell* target, class GamePage* gamePage);   // false if the move isn't legal
     bool canAttack(Agent* target, class GamePage* gamePage) const;
     void attack(Agent* target, class GamePage* gamePage);
     void takeDamage(int amount);
+    void restoreState(int currentHP, int remainingMoves);
+
+    // Name label and health bar; hidden while the board is zoomed out (see BoardNavigator.h)
+    void setShowDetails(bool show);
     
     // Visual feedback for placement
     void showPlacementZones(const QList<Cell*>& allCells);
@@ -53,6 +57,11 @@ public:
     static void showPlacementZonesForType(AgentType type, const QList<Cell*>& allCells);
     static void hidePlacementZones(const QList<Cell*>& allCells);
 
+protected:
+#ifdef TM_PROFILING
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+#endif
+
 private:
     Player* m_owner;
     QString m_name;
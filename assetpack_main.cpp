@@ -0,0 +1,149 @@
+// assetpack_main.cpp - Build-time tool that packs the game's pictures
+//
+//   tm_assetpack assets.txt <source dir> <output dir>
+//
+// Reads the manifest (see assets.txt), writes every picture at the sizes
+// listed there into the output directory, together with assets.qrc naming
+// them all and assets.index describing the extra sizes. The build then
+// compiles assets.qrc with rcc into the game.
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageWriter>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTextStream>
+
+namespace {
+
+const char* const Prefix = "/new/prefix1";
+const int JpegQuality = 90;
+
+struct Variant {
+    int width = 0;
+    int height = 0;
+    bool stretch = false;   // "WxH!": exactly that size, aspect ratio ignored
+};
+
+bool parseSize(const QString& text, Variant& variant) {
+    static const QRegularExpression pattern("^(\\d+)x(\\d+)(!?)$");
+    const QRegularExpressionMatch match = pattern.match(text);
+    if (!match.hasMatch()) return false;
+    variant.width = match.captured(1).toInt();
+    variant.height = match.captured(2).toInt();
+    variant.stretch = !match.captured(3).isEmpty();
+    return variant.width > 0 && variant.height > 0;
+}
+
+bool writeScaled(const QImage& image, const Variant& variant, const QString& path) {
+    const QImage scaled = image.scaled(variant.width, variant.height,
+                                       variant.stretch ? Qt::IgnoreAspectRatio : Qt::KeepAspectRatio,
+                                       Qt::SmoothTransformation);
+    QImageWriter writer(path);
+    writer.setQuality(JpegQuality);
+    if (!writer.write(scaled)) {
+        qCritical() << "Cannot write" << path << ":" << writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() != 4) {
+        qCritical() << "Usage: tm_assetpack <manifest> <source dir> <output dir>";
+        return 1;
+    }
+
+    QFile manifest(args[1]);
+    if (!manifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCritical() << "Cannot open" << args[1];
+        return 1;
+    }
+    const QDir sourceDir(args[2]);
+    const QDir outputDir(args[3]);
+    if (!outputDir.mkpath(".")) {
+        qCritical() << "Cannot create" << args[3];
+        return 1;
+    }
+
+    QString qrc;
+    QTextStream qrcOut(&qrc);
+    qrcOut << "<RCC>\n    <qresource prefix=\"" << Prefix << "\">\n";
+    QString index;
+    QTextStream indexOut(&index);
+
+    const QStringList lines = QString::fromUtf8(manifest.readAll()).split('\n');
+    for (int lineIndex = 0; lineIndex < lines.size(); ++lineIndex) {
+        const QString line = lines[lineIndex].trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        const QStringList fields = line.split(QRegularExpression("\\s+"));
+        const QString name = fields[0];
+        if (fields.size() < 2) {
+            qCritical().noquote() << QString("%1:%2: no sizes for %3").arg(args[1]).arg(lineIndex + 1).arg(name);
+            return 1;
+        }
+
+        // As is: copied, keeping whatever format (and animation) it has. Any
+        // sizes after it are extras, as after a first size
+        int firstSize = 1;
+        if (fields[1] == "-") {
+            const QString target = outputDir.filePath(name);
+            QFile::remove(target);
+            if (!QFile::copy(sourceDir.filePath(name), target)) {
+                qCritical() << "Cannot copy" << sourceDir.filePath(name);
+                return 1;
+            }
+            qrcOut << "        <file>" << name << "</file>\n";
+            if (fields.size() == 2) continue;
+            firstSize = 2;
+        }
+
+        const QImage image(sourceDir.filePath(name));
+        if (image.isNull()) {
+            qCritical() << "Cannot read" << sourceDir.filePath(name);
+            return 1;
+        }
+        const QFileInfo info(name);
+        for (int i = firstSize; i < fields.size(); ++i) {
+            Variant variant;
+            if (!parseSize(fields[i], variant)) {
+                qCritical().noquote() << QString("%1:%2: bad size %3").arg(args[1]).arg(lineIndex + 1).arg(fields[i]);
+                return 1;
+            }
+
+            // The first size stands in for the original
+            const QString file = i == 1 ? name
+                                        : QString("%1@%2x%3.%4").arg(info.completeBaseName()).arg(variant.width)
+                                              .arg(variant.height).arg(info.suffix());
+            if (!writeScaled(image, variant, outputDir.filePath(file))) return 1;
+            qrcOut << "        <file>" << file << "</file>\n";
+            indexOut << name << ' ' << variant.width << 'x' << variant.height << ' ' << file << '\n';
+        }
+    }
+
+    QFile indexFile(outputDir.filePath("assets.index"));
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCritical() << "Cannot write" << indexFile.fileName();
+        return 1;
+    }
+    indexFile.write(index.toUtf8());
+    indexFile.close();
+    qrcOut << "        <file>assets.index</file>\n    </qresource>\n</RCC>\n";
+
+    QFile qrcFile(outputDir.filePath("assets.qrc"));
+    if (!qrcFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCritical() << "Cannot write" << qrcFile.fileName();
+        return 1;
+    }
+    qrcFile.write(qrc.toUtf8());
+    return 0;
+}
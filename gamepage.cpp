@@ -1,11 +1,25 @@
 #include "gamepage.h"
 #include <QFile>
 #include <QTextStream>
-#include <QQueue>
-#include <QSet>
+#include <QtAlgorithms>
 #include "AgentCardWidget.h"
+#include "BoardNavigator.h"
+#include "GameSnapshot.h"
+#include "HexBoard.h"
+#include "Log.h"
+#include "MapGenerator.h"
+#include "MapValidator.h"
+#include "MoveAnimator.h"
+#include "Profiler.h"
+#include "TerrainLayer.h"
+#include "ThreatOverlay.h"
+#include "TraceRecorder.h"
 #include "agent.h"
 
+static_assert(int(Cell::Normal) == int(HexBoard::Normal) && int(Cell::Water) == int(HexBoard::Water)
+              && int(Cell::Rock) == int(HexBoard::Rock) && int(Cell::Goal) == int(HexBoard::Goal),
+              "HexBoard::Terrain must match Cell::CellType");
+
 GamePage::GamePage(QComboBox* mapSelector, QGraphicsView* gameView,
                    Player* player1, Player* player2, QObject* parent)
     : QObject(parent), m_mapSelector(mapSelector), m_gameView(gameView),
@@ -13,6 +27,15 @@ GamePage::GamePage(QComboBox* mapSelector, QGraphicsView* gameView,
 {
     m_scene = new QGraphicsScene(this);
     m_gameView->setScene(m_scene);
+    m_navigator = new BoardNavigator(m_gameView, this);
+    connect(m_navigator, &BoardNavigator::detailChanged, this, [this](bool showsDetail) {
+        for (Agent* agent : allAgents()) agent->setShowDetails(showsDetail);
+    });
+    connect(m_navigator, &BoardNavigator::cellClicked, this, &GamePage::onBoardClicked);
+    connect(m_navigator, &BoardNavigator::cellHovered, this, [this](int index) {
+        emit cellHovered(index >= 0 ? m_cells[index] : nullptr);
+    });
+    m_animator = new MoveAnimator(this);
     m_mapSelector->clear();
     m_mapSelector->addItems({
         "grid1.txt", "grid2.txt", "grid3.txt", "grid4.txt",
@@ -23,6 +46,7 @@ GamePage::GamePage(QComboBox* mapSelector, QGraphicsView* gameView,
 }
 
 GamePage::~GamePage() {
+    clearAgents();
     qDeleteAll(m_cells);
     m_cells.clear();
 }
@@ -40,7 +64,15 @@ void GamePage::endTurn() {
     }
     
     m_currentPlayer->endTurn();
-    m_currentPlayer = (m_currentPlayer == m_player1) ? m_player2 : m_player1;
+    const int next = GameRules::nextPlayer(m_currentPlayer == m_player1 ? 0 : 1);
+    m_currentPlayer = next == 0 ? m_player1 : m_player2;
+
+    // The agents whose moves are about to be refilled are part of the action
+    for (Agent* agent : m_currentPlayer->getAgents()) {
+        if (agent && agent->isAlive() && agent->getRemainingMoves() != agent->getMobility()) {
+            recordAgent(agent);
+        }
+    }
     m_currentPlayer->startTurn();
     
     // Reset all current player's agents' moves for the new turn
@@ -50,7 +82,8 @@ void GamePage::endTurn() {
         }
     }
     
-    emit gameStateChanged();
+    updateOverlays();   // Hot seat: the other player's view now
+    markChanged(TurnChanged | SelectionChanged | AgentsChanged);
 }
 
 bool GamePage::isGameOver() const {
@@ -72,93 +105,100 @@ const QVector<Cell*>& GamePage::getCells() const {
 }
 
 Cell* GamePage::getCellAt(int row, int col) const {
-    for (Cell* cell : m_cells) {
-        if (cell->getRow() == row && cell->getCol() == col) {
-            return cell;
-        }
-    }
-    return nullptr;
+    if (!m_board) return nullptr;
+    const int index = m_board->indexAt(row, col);
+    return index >= 0 ? m_cells[index] : nullptr;
+}
+
+void GamePage::onBoardClicked(int index) {
+    Cell* cell = index >= 0 ? m_cells[index] : nullptr;
+    onCellInteraction(cell);
+    if (cell) emit cellClicked(cell);
 }
 
 void GamePage::loadSelectedMap(const QString &mapName) {
-    m_scene->clear();
-    m_cells.clear();
-    loadMap(":/new/prefix1/" + mapName);
+    loadMap(":/new/prefix1/" + mapName, mapName);
 }
 
-void GamePage::loadMap(const QString &path) {
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Cannot open file:" << path;
-        return;
-    }
+void GamePage::loadMap(const QString &path, const QString &mapName) {
+    TM_TRACE_SPAN("map load", "game");
+    showBoard(HexBoard::fromFile(path, mapName), mapName);
+}
 
+void GamePage::showBoard(QSharedPointer<const HexBoard> board, const QString& mapName) {
+    // Agents live in the scene too; detach them from their players first so
+    // nobody keeps pointers to items deleted by QGraphicsScene::clear()
+    m_animator->finishAll();
+    clearAgents();
+    m_scene->clear();
+    m_threatOverlay = nullptr;
+    m_cells.clear();
+    m_navigator->setBoard(nullptr);
+    m_highlightedCells.clear();
+    m_highlightsUntracked = true;
+    markChanged(BoardChanged);
+    m_mapName = mapName;
     m_player1PlacementZones.clear();
     m_player2PlacementZones.clear();
 
-    QTextStream in(&file);
-    int row = 1;
-    int haxnum = 0;
-    while (haxnum < 41) {
-        QString line = in.readLine();
-        for (int col = 0; col + 1 < line.length(); col += 3) {
-            QString cell = line.mid(col, 2);
-            if (!cell.isEmpty() && line[col] == '/') {
-                Cell::CellType type = Cell::Normal;
-                bool isPlacementZone = false;
-                int placementPlayer = -1;
-                
-                if (cell == "/~") type = Cell::Water;
-                else if (cell == "/#") type = Cell::Rock;
-                else if (cell == "/*") type = Cell::Goal;
-                else if (cell == "/1") {
-                    type = Cell::Normal;
-                    isPlacementZone = true;
-                    placementPlayer = 0;
-                }
-                else if (cell == "/2") {
-                    type = Cell::Normal;
-                    isPlacementZone = true;
-                    placementPlayer = 1;
-                }
-                
-                Cell* newCell = createCell(row, col / 3, type);
-                
-                if (isPlacementZone) {
-                    if (placementPlayer == 0) {
-                        m_player1PlacementZones.append(newCell);
-                    } else {
-                        m_player2PlacementZones.append(newCell);
-                    }
-                }
-                
-                haxnum++;
-            }
+    m_board = board;
+    m_snapshotBoard.clear();
+    if (!m_board) {
+        return;
+    }
+    MapValidator::logProblems(*m_board);
+
+    QRectF bounds;
+    for (int i = 0; i < m_board->cellCount(); ++i) {
+        Cell* newCell = createCell(m_board->row(i), m_board->col(i), Cell::CellType(m_board->terrain(i)));
+        bounds |= newCell->boundingRect();
+        
+        if (m_board->zone(i) == 1) {
+            m_player1PlacementZones.append(newCell);
+        } else if (m_board->zone(i) == 2) {
+            m_player2PlacementZones.append(newCell);
         }
-        row++;
     }
-    file.close();
+    // Fixed, so the scene never re-measures every item to find its extent
+    m_scene->setSceneRect(bounds);
+    m_navigator->setBoard(m_board.data());
+
+    // Under the cells, which from now on only paint what differs from it
+    m_scene->addItem(new TerrainLayer(m_cells));
+
+    // Above the cells; agents are added later, so they stay on top
+    m_threatOverlay = new ThreatOverlay(m_cells);
+    m_threatOverlay->setVisible(m_threatOverlayEnabled);
+    m_scene->addItem(m_threatOverlay);
+
+    m_fogShown.clear();
+    rebuildFog();
+    rebuildThreats();
+}
+
+void GamePage::addAgentItem(Agent* agent) {
+    agent->setShowDetails(m_navigator->showsDetail());
+    m_scene->addItem(agent);
 }
 
 Cell* GamePage::createCell(int row, int col, Cell::CellType type) {
     Cell* cell = new Cell(row, col, type);
+    cell->setIndex(m_cells.size());
     m_scene->addItem(cell);
     m_cells.append(cell);
-    
-    connect(cell, &Cell::clicked, this, &GamePage::onCellInteraction);
-    connect(cell, &Cell::clicked, this, &GamePage::cellClicked);
-    
     return cell;
 }
 
 void GamePage::onCellInteraction(Cell* cell) {
+    TM_PROFILE_FRAME();
+
     // Null check for clicks outside the game board
     if (!cell) {
         // Clicking outside board should clear selection in battle phase
         if (m_battlePhaseActive && m_selectedAgent) {
             clearAllHighlights();
             m_selectedAgent = nullptr;
-            emit gameStateChanged();
+            markChanged(SelectionChanged);
         }
         return;
     }
@@ -168,44 +208,28 @@ void GamePage::onCellInteraction(Cell* cell) {
         if (m_placableCells.contains(cell) && m_currentPlacementCard) {
             if (placeAgent(m_currentPlacementCard, cell, m_currentPlacementPlayer)) {
                 endPlacement();
+                markChanged(AgentsChanged | HighlightsChanged);
             }
         }
     } else if (m_battlePhaseActive) {
         // Battle phase
         if (m_selectedAgent) {
-            bool actionPerformed = false;
-            
-            if (m_selectedAgent->canMoveTo(cell, this)) {
-                m_selectedAgent->moveTo(cell, this);
-                actionPerformed = true;
-            } else if (Agent* target = cell->getAgent()) {
-                if (m_selectedAgent->canAttack(target, this)) {
-                    m_selectedAgent->attack(target, this);
-                    actionPerformed = true;
-
-                    // Clear selected agent if it died during attack
-                    if (!m_selectedAgent->isAlive()) {
-                        m_selectedAgent = nullptr;
-                    }
-
-                    // Check for game over
-                    if (isGameOver()) {
-                        emit gameOver(getWinner());
-                        return;
-                    }
-                }
-            }
+            const int fromCell = m_selectedAgent->getCell()->getIndex();
             
             // Clear all highlights and reset selection
             clearAllHighlights();
             m_selectedAgent = nullptr;
+            markChanged(SelectionChanged);
             
-            // If an action was performed, automatically end the turn (1 agent per turn)
-            if (actionPerformed) {
-                endTurn();
+            if (m_networkRole == Client && !m_lockstep) {
+                // The host decides; the result comes back as a delta
+                emit actionRequested(fromCell, cell->getIndex());
+            } else if (performAction(fromCell, cell->getIndex())) {
+                emit localActionPerformed(fromCell, cell->getIndex(), m_checksum);
+                if (isGameOver()) return;
             }
             
-        } else if (cell->getAgent() && cell->getAgent()->getOwner() == m_currentPlayer) {
+        } else if (cell->getAgent() && cell->getAgent()->getOwner() == m_currentPlayer && isLocalTurn()) {
             // Clear any previous highlights
             clearAllHighlights();
             
@@ -223,21 +247,150 @@ void GamePage::onCellInteraction(Cell* cell) {
             
             // Highlight attackable enemies
             highlightAttackableEnemies(m_selectedAgent);
-        } else {
+            markChanged(SelectionChanged | HighlightsChanged);
+        } else if (m_selectedAgent || !m_highlightedCells.isEmpty() || m_highlightsUntracked) {
             // Clicked on empty cell or invalid target - clear selection
             clearAllHighlights();
             m_selectedAgent = nullptr;
+            markChanged(SelectionChanged);
         }
     }
     // Don't allow agent selection during placement phase
-    emit gameStateChanged();
 }
+
+bool GamePage::performAction(int fromCell, int toCell) {
+    TM_PROFILE_SCOPE(Action);
+    TM_TRACE_SPAN("action", "game");
+    if (!m_battlePhaseActive || isGameOver()) return false;
+    if (fromCell < 0 || fromCell >= m_cells.size() || toCell < 0 || toCell >= m_cells.size()) return false;
+
+    Agent* agent = m_cells[fromCell]->getAgent();
+    Cell* cell = m_cells[toCell];
+    if (!agent || agent->getOwner() != m_currentPlayer) return false;
+
+    // A new action before the last one finished animating: skip to the end
+    m_animator->finishAll();
+
+    bool actionPerformed = false;
+    beginRecording();
+    recordAgent(agent);                // Moves, takes counter damage, may land elsewhere
+    recordAgent(cell->getAgent());     // Takes the damage
+
+    if (agent->moveTo(cell, this)) {
+        actionPerformed = true;
+    } else if (Agent* target = cell->getAgent()) {
+        if (agent->canAttack(target, this)) {
+            agent->attack(target, this);
+            actionPerformed = true;
+        }
+    }
+
+    if (!actionPerformed) {
+        m_recordingActive = false;
+        return false;
+    }
+
+    // One agent acts per turn; the turn passes automatically unless the game is over
+    const bool gameEnded = isGameOver();
+    if (!gameEnded) {
+        endTurn();
+    }
+
+    if (m_lockstep) {
+        m_checksum = stateChecksum(m_checksum);
+    }
+
+    GameDelta delta = endRecording();
+    m_history.push(delta);
+    updateOverlays();
+    markChanged(AgentsChanged);
+    emit actionApplied(delta);
+
+    if (gameEnded) {
+        emit gameOver(getWinner());
+    }
+    return true;
+}
+
+void GamePage::applyRemoteDelta(const GameDelta& delta) {
+    m_selectedAgent = nullptr;
+    applyDelta(delta, false);
+    clearAllHighlights();
+    markChanged(TurnChanged | SelectionChanged | AgentsChanged);
+
+    if (isGameOver()) {
+        emit gameOver(getWinner());
+    }
+}
+
+void GamePage::setNetworkRole(NetworkRole role, int localPlayer) {
+    m_networkRole = role;
+    m_localPlayer = localPlayer;
+    if (role == Local) {
+        m_lockstep = false;
+    }
+}
+
+void GamePage::startLockstep(quint32 seed) {
+    m_random.setSeed(seed);
+    m_checksum = seed;
+    m_lockstep = true;
+}
+
+quint32 GamePage::stateChecksum(quint32 previous) const {
+    // Everything an action can change, in agent id order, plus the RNG so a
+    // diverged random stream is caught before it picks a different cell
+    StateChecksum checksum(previous);
+    for (Agent* agent : allAgents()) {
+        checksum.add(agent->getCell() ? agent->getCell()->getIndex() : -1);
+        checksum.add(agent->getCurrentHP());
+        checksum.add(agent->getRemainingMoves());
+    }
+    checksum.add(m_currentPlayer == m_player1 ? 0 : 1);
+    checksum.add(qint32(m_random.state()));
+    return checksum.value();
+}
+
+bool GamePage::applyLockstepAction(int fromCell, int toCell, quint32 expectedChecksum) {
+    if (!m_lockstep || isLocalTurn()) return false;
+
+    m_selectedAgent = nullptr;
+    clearAllHighlights();
+    if (!performAction(fromCell, toCell)) return false;
+
+    markChanged(SelectionChanged);
+    return m_checksum == expectedChecksum;
+}
+
+bool GamePage::isLocalTurn() const {
+    if (m_localPlayer < 0) return true;
+    return (m_currentPlayer == m_player1) == (m_localPlayer == 0);
+}
+
+void GamePage::markChanged(Changes changes) {
+    // The first change of an iteration schedules the one notification
+    if (!m_pendingChanges) {
+        QMetaObject::invokeMethod(this, [this]() { flushChanges(); }, Qt::QueuedConnection);
+    }
+    m_pendingChanges |= changes;
+}
+
+void GamePage::flushChanges() {
+    const Changes changes = m_pendingChanges;
+    m_pendingChanges = Changes();
+    if (changes) {
+        emit gameStateChanged(changes);
+    }
+}
+
 void GamePage::startPlacement(const QList<Cell*>& placableCells) {
     m_placementMode = true;
     m_placableCells = placableCells;
+    m_highlightsUntracked = true;
     for (Cell* cell : m_cells) {
         if (placableCells.contains(cell)) {
             cell->setBrush(QBrush(QColor(100, 255, 100, 150))); // Light green
+            TM_PROFILE_COUNT(BrushChanges, 1);
         }
     }
 }
@@ -263,6 +416,7 @@ void GamePage::startAgentPlacement(AgentCardWidget* card, int playerIndex) {
     m_placementMode = true;
     
     // Don't highlight here - let TacticalMonster handle it
+    m_highlightsUntracked = true;
     QList<Cell*> validCells = getValidPlacementCells(playerIndex);
     m_placableCells = validCells;
 }
@@ -284,6 +438,7 @@ QList<Cell*> GamePage::getValidPlacementCells(int playerIndex) const {
 }
 
 bool GamePage::placeAgent(AgentCardWidget* card, Cell* cell, int playerIndex) {
+    TM_TRACE_SPAN("placement", "game");
     if (!card || !cell || cell->isOccupied()) {
         return false;
     }
@@ -301,8 +456,9 @@ bool GamePage::placeAgent(AgentCardWidget* card, Cell* cell, int playerIndex) {
     agent->setCell(cell);
     
     // Add the agent to the scene and player
-    m_scene->addItem(agent);
+    addAgentItem(agent);
     player->addAgent(agent);
+    updateOverlays();
     
     return true;
 }
@@ -310,6 +466,9 @@ bool GamePage::placeAgent(AgentCardWidget* card, Cell* cell, int playerIndex) {
 void GamePage::activateBattlePhase() {
     m_battlePhaseActive = true;
     m_placementMode = false;
+    m_history.clear();
+    m_highlightsUntracked = true;
+    markChanged(AllChanges);
     
     // Reset all agents' moves for the battle phase
     for (Agent* agent : m_player1->getAgents()) {
@@ -335,161 +494,257 @@ void GamePage::resetBattleState() {
 
 QList<Cell*> GamePage::getAdjacentCells(Cell* cell) const {
     QList<Cell*> adjacent;
-    if (!cell) return adjacent;
+    if (!cell || !m_board) return adjacent;
     
-    int row = cell->getRow();
-    int col = cell->getCol();
-    
-    // Define hex grid adjacency offsets for neighbor finding
-    QList<QPair<int, int>> offsets = {
-        {-1, 0}, {-1, 1}, {0, 1}, {1, 0}, {0, -1}, {-1, -1},
-        {1, 1}, {1, -1}, {-1, -2}, {-1, 2}, {0, -2}, {0, 2}
-    };
-    
-    for (const auto& offset : offsets) {
-        int newRow = row + offset.first;
-        int newCol = col + offset.second;
-        
-        if (newRow >= 0 && newCol >= 0) {
-            Cell* neighborCell = getCellAt(newRow, newCol);
-            if (neighborCell) {
-                int dr = abs(newRow - row);
-                int dc = abs(newCol - col);
-                
-                // Validate proximity for hex grid adjacency
-                if ((dr <= 1 && dc <= 1) || (dr <= 2 && dc == 0) || (dr == 0 && dc <= 2)) {
-                    if (!adjacent.contains(neighborCell)) {
-                        adjacent.append(neighborCell);
-                    }
-                }
-            }
-        }
+    // Neighbours are precomputed once per map by HexBoard
+    const int index = cell->getIndex();
+    for (const int* it = m_board->neighborsBegin(index); it != m_board->neighborsEnd(index); ++it) {
+        adjacent.append(m_cells[*it]);
     }
     return adjacent;
 }
 
 QList<Cell*> GamePage::getReachableCells(Cell* startCell, int maxDistance, Agent* agent) const {
+    TM_PROFILE_SCOPE(ReachableBfs);
     QList<Cell*> reachable;
-    if (!startCell || maxDistance <= 0) return reachable;
-    
-    // BFS to find all reachable cells within maxDistance
-    QQueue<QPair<Cell*, int>> queue; // Cell and current distance
-    QSet<Cell*> visited;
-    
-    queue.enqueue({startCell, 0});
-    visited.insert(startCell);
-    
-    while (!queue.isEmpty()) {
-        QPair<Cell*, int> current = queue.dequeue();
-        Cell* currentCell = current.first;
-        int currentDistance = current.second;
-        
-        // Check if this cell can be a final destination (not just passed through)
-        if (currentDistance > 0 && !currentCell->isOccupied()) { 
-            // Agent must be able to be PLACED on the destination cell
-            if (!agent || agent->canBePlacedOn(currentCell->getType())) {
-                reachable.append(currentCell);
-            }
-        }
-        
-        if (currentDistance < maxDistance) {
-            QList<Cell*> neighbors = getAdjacentCells(currentCell);
-            
-            for (Cell* neighbor : neighbors) {
-                if (!visited.contains(neighbor)) {
-                    // For pathfinding, check if agent can move THROUGH this cell
-                    bool canPassThrough = false;
-                    if (agent) {
-                        if (neighbor->isOccupied()) {
-                            canPassThrough = false;
-                        } else {
-                            canPassThrough = agent->canMoveThrough(neighbor->getType());
-                        }
-                    } else {
-                        canPassThrough = !neighbor->isOccupied();
-                    }
-                    
-                    if (canPassThrough) {
-                        visited.insert(neighbor);
-                        queue.enqueue({neighbor, currentDistance + 1});
-                    }
-                }
-            }
+    if (!startCell || maxDistance <= 0 || !m_board) return reachable;
+
+    // Every cell whose cheapest path fits in maxDistance moves
+    if (agent) {
+        GameRules::searchMoves(m_search, *m_board, agent->getType(), startCell->getIndex(), maxDistance,
+                               [&](int cell) { return m_cells[cell]->isOccupied(); });
+    } else {
+        m_search.run(*m_board, startCell->getIndex(), maxDistance, [&](int cell) {
+            return m_cells[cell]->isOccupied() ? 0 : 1;
+        });
+    }
+    TM_PROFILE_COUNT(BfsNodes, m_search.settled().size());
+
+    for (int index : m_search.settled()) {
+        Cell* cell = m_cells[index];
+        // Agent must be able to be PLACED on the destination cell, not just pass it
+        if (cell != startCell && (!agent || agent->canBePlacedOn(cell->getType()))) {
+            reachable.append(cell);
         }
     }
-    
     return reachable;
 }
 
 QList<Cell*> GamePage::getCellsInRange(Cell* centerCell, int range) const {
+    TM_PROFILE_SCOPE(RangeBfs);
     QList<Cell*> inRange;
-    if (!centerCell || range <= 0) return inRange;
-    
-    // BFS to find all cells within range (for attack range)
-    QQueue<QPair<Cell*, int>> queue;
-    QSet<Cell*> visited;
-    
-    queue.enqueue({centerCell, 0});
-    visited.insert(centerCell);
-    
-    while (!queue.isEmpty()) {
-        QPair<Cell*, int> current = queue.dequeue();
-        Cell* currentCell = current.first;
-        int currentDistance = current.second;
-        
-        if (currentDistance > 0) { // Don't include the center cell
-            inRange.append(currentCell);
-        }
-        
-        if (currentDistance < range) {
-            QList<Cell*> neighbors = getAdjacentCells(currentCell);
-            for (Cell* neighbor : neighbors) {
-                if (!visited.contains(neighbor)) {
-                    visited.insert(neighbor);
-                    queue.enqueue({neighbor, currentDistance + 1});
-                }
-            }
-        }
+    if (!centerCell || !m_board) return inRange;
+
+    const QVector<int>& cells = m_range.run(*m_board, centerCell->getIndex(), range);
+    TM_PROFILE_COUNT(BfsNodes, cells.size() + 1);
+    inRange.reserve(cells.size());
+    for (int index : cells) {
+        inRange.append(m_cells[index]);
     }
-    
     return inRange;
 }
 
 int GamePage::getBFSDistance(Cell* from, Cell* to, Agent* agent) const {
+    TM_PROFILE_SCOPE(DistanceBfs);
     if (!from || !to || from == to) return 0;
-    
-    // BFS to find shortest path distance
-    QQueue<QPair<Cell*, int>> queue;
-    QSet<Cell*> visited;
-    
-    queue.enqueue({from, 0});
-    visited.insert(from);
-    
-    while (!queue.isEmpty()) {
-        QPair<Cell*, int> current = queue.dequeue();
-        Cell* currentCell = current.first;
-        int currentDistance = current.second;
-        
-        if (currentCell == to) {
-            return currentDistance;
+    if (getPath(from, to, agent).isEmpty()) return -1; // Path not found
+    return m_search.cost(to->getIndex());
+}
+
+QList<Cell*> GamePage::getPath(Cell* from, Cell* to, Agent* agent) const {
+    QList<Cell*> path;
+    if (!from || !to || !m_board) return path;
+
+    // Cheapest path; the destination may be occupied. Without an agent
+    // nothing blocks.
+    if (agent) {
+        GameRules::pathCost(m_search, *m_board, agent->getType(), from->getIndex(), to->getIndex(),
+                            [&](int cell) { return m_cells[cell]->isOccupied(); });
+    } else {
+        m_search.run(*m_board, from->getIndex(), -1, [](int) { return 1; }, to->getIndex());
+    }
+    TM_PROFILE_COUNT(BfsNodes, m_search.settled().size());
+
+    if (m_search.cost(to->getIndex()) == MoveSearch::Unreached) return path;
+    for (int cell = to->getIndex(); cell != from->getIndex(); cell = m_search.parent(cell)) {
+        path.prepend(m_cells[cell]);
+    }
+    path.prepend(from);
+    return path;
+}
+
+int GamePage::moveCost(Agent* agent, Cell* target, QList<Cell*>* path) const {
+    if (!agent || !agent->getCell() || !target || !m_board) return -1;
+    const int from = agent->getCell()->getIndex();
+    const int cost = GameRules::moveCost(m_search, *m_board, agent->getType(), from, target->getIndex(),
+                                         agent->getRemainingMoves(),
+                                         [&](int cell) { return m_cells[cell]->isOccupied(); });
+    if (path && cost >= 0) {
+        path->clear();
+        for (int cell = target->getIndex(); cell != from; cell = m_search.parent(cell)) {
+            path->prepend(m_cells[cell]);
         }
-        
-        QList<Cell*> neighbors = getAdjacentCells(currentCell);
-        for (Cell* neighbor : neighbors) {
-            if (!visited.contains(neighbor)) {
-                // Check if agent can move through this cell (if agent is provided)
-                if (!agent || (!neighbor->isOccupied() && agent->canMoveThrough(neighbor->getType())) || neighbor == to) {
-                    visited.insert(neighbor);
-                    queue.enqueue({neighbor, currentDistance + 1});
+        path->prepend(agent->getCell());
+    }
+    return cost;
+}
+
+bool GamePage::isInRange(Cell* from, Cell* to, int range) const {
+    if (!from || !to || !m_board) return false;
+    return m_range.reaches(*m_board, from->getIndex(), to->getIndex(), range);
+}
+
+Cell* GamePage::landingCell(Agent* attacker, Cell* targetCell) {
+    if (!attacker || !targetCell || !m_board) return nullptr;
+    const int index = GameRules::landingCell(*m_board, attacker->getType(), targetCell->getIndex(), m_random,
+                                             [&](int cell) { return m_cells[cell]->isOccupied(); });
+    return index >= 0 ? m_cells[index] : nullptr;
+}
+
+void GamePage::setLineOfSight(bool enabled) {
+    m_lineOfSight = enabled;
+    rebuildFog();   // Rock hides cells from sight too
+    rebuildThreats();
+}
+
+void GamePage::setFogOfWar(bool enabled) {
+    m_fogOfWar = enabled;
+    rebuildFog();
+    updateThreats();
+}
+
+void GamePage::setThreatOverlay(bool enabled) {
+    m_threatOverlayEnabled = enabled;
+    if (m_threatOverlay) m_threatOverlay->setVisible(enabled);
+    rebuildThreats();   // Nothing was tracked while it was off
+}
+
+int GamePage::viewingPlayer() const {
+    return m_localPlayer >= 0 ? m_localPlayer : (m_currentPlayer == m_player1 ? 0 : 1);
+}
+
+void GamePage::updateOverlays() {
+    updateFog();
+    updateThreats();   // After the fog: it decides which enemies are known
+}
+
+void GamePage::rebuildFog() {
+    m_fog.reset(m_board, m_lineOfSight);
+    m_fogViewerCells.clear();
+    updateFog();
+}
+
+void GamePage::updateFog() {
+    const int viewer = viewingPlayer();
+
+    // Move the sight of every agent whose cell changed since the last call;
+    // FogOfWar only touches the cells around those
+    if (m_fogOfWar && m_board) {
+        for (Player* player : {m_player1, m_player2}) {
+            const int playerIndex = player == m_player1 ? 0 : 1;
+            for (Agent* agent : player->getAgents()) {
+                const int cell = (agent->isAlive() && agent->getCell()) ? agent->getCell()->getIndex() : -1;
+                const int previous = m_fogViewerCells.value(agent, -1);
+                if (cell != previous) {
+                    m_fog.moveViewer(playerIndex, previous, cell);
+                    m_fogViewerCells.insert(agent, cell);
                 }
             }
         }
     }
-    
-    return -1; // Path not found
+
+    // Redraw only the cells whose visibility differs from what is on screen
+    const int words = (m_cells.size() + 63) / 64;
+    if (m_fogShown.size() != words) {
+        m_fogShown.fill(~quint64(0), words);
+    }
+    for (int word = 0; word < words; ++word) {
+        const quint64 visible = m_fogOfWar ? m_fog.bits(viewer)[word] : ~quint64(0);
+        quint64 flipped = m_fogShown[word] ^ visible;
+        m_fogShown[word] = visible;
+        while (flipped) {
+            const int cell = word * 64 + qCountTrailingZeroBits(flipped);
+            flipped &= flipped - 1;
+            if (cell < m_cells.size()) {
+                m_cells[cell]->setDimmed(!((visible >> (cell & 63)) & 1));
+            }
+        }
+    }
+
+    // A handful of sprites: just go over all of them
+    for (Agent* agent : allAgents()) {
+        const bool own = (agent->getOwner() == m_player1) == (viewer == 0);
+        Cell* cell = agent->getCell();
+        agent->setVisible(own || !m_fogOfWar || (cell && m_fog.isVisible(viewer, cell->getIndex())));
+    }
+}
+
+void GamePage::rebuildThreats() {
+    if (!m_threatOverlayEnabled) return;
+    m_threats.reset(m_board, m_lineOfSight);
+    m_threatViewer = -1;
+    updateThreats();
+}
+
+void GamePage::updateThreats() {
+    if (!m_threatOverlayEnabled || !m_threatOverlay) return;
+    const int viewer = viewingPlayer();
+
+    // Agents the map already has are skipped unless something about them
+    // changed; see ThreatMap::setAgent
+    const QList<Agent*> agents = allAgents();
+    for (int id = 0; id < agents.size(); ++id) {
+        Agent* agent = agents[id];
+        Cell* cell = agent->getCell();
+        ThreatSource source;
+        source.owner = agent->getOwner() == m_player1 ? 0 : 1;
+        source.type = agent->getType();
+        const bool known = source.owner == viewer || !m_fogOfWar
+                           || (cell && m_fog.isVisible(viewer, cell->getIndex()));
+        source.cell = (agent->isAlive() && cell && known) ? cell->getIndex() : -1;
+        source.moves = agent->getOwner() == m_currentPlayer ? agent->getRemainingMoves() : agent->getMobility();
+        source.damage = agent->getDamage();
+        source.attackRange = agent->getAttackRange();
+        m_threats.setAgent(id, source);
+    }
+    m_threats.setAgentCount(agents.size());
+
+    const int enemy = 1 - viewer;
+    const QVector<int> changed = m_threats.takeChangedCells();
+    if (viewer != m_threatViewer) {
+        // Hot seat turn change or a fresh map: show the other side's threat
+        m_threatViewer = viewer;
+        for (int cell = 0; cell < m_cells.size(); ++cell) {
+            m_threatOverlay->setThreat(cell, m_threats.threatCount(enemy, cell), m_threats.threatDamage(enemy, cell));
+        }
+    } else {
+        for (int cell : changed) {
+            m_threatOverlay->setThreat(cell, m_threats.threatCount(enemy, cell), m_threats.threatDamage(enemy, cell));
+        }
+    }
+}
+
+bool GamePage::hasLineOfSight(Cell* from, Cell* to) const {
+    if (!m_lineOfSight) return true;
+    if (!from || !to || !m_board) return false;
+    return m_board->isVisible(from->getIndex(), to->getIndex());
+}
+
+void GamePage::animateAgent(Agent* agent, const QList<Cell*>& path) {
+    QVector<QPointF> waypoints;
+    waypoints.reserve(path.size());
+    for (Cell* cell : path) {
+        waypoints.append(cell->getCenter());
+    }
+    m_animator->animate(agent, waypoints);
+}
+
+void GamePage::setAnimatedMoves(bool enabled) {
+    m_animator->setEnabled(enabled);
 }
 
 void GamePage::highlightMovementCells(Agent* agent) {
+    TM_PROFILE_SCOPE(Highlight);
     if (!agent) return;
     
     // Get reachable cells for agent
@@ -499,45 +754,33 @@ void GamePage::highlightMovementCells(Agent* agent) {
     for (Cell* cell : reachableCells) {
         if (!cell->isOccupied()) {
             cell->setBrush(QBrush(QColor(50, 100, 255, 200)));
+            m_highlightedCells.append(cell);
+            TM_PROFILE_COUNT(BrushChanges, 1);
         }
     }
 }
 
 void GamePage::highlightPassableCells(Agent* agent) {
-    if (!agent) return;
+    TM_PROFILE_SCOPE(Highlight);
+    if (!agent || !agent->getCell() || !m_board) return;
     
     // Show cells agent can pass through but not necessarily stop on
-    QQueue<QPair<Cell*, int>> queue;
-    QSet<Cell*> visited;
-    
-    queue.enqueue({agent->getCell(), 0});
-    visited.insert(agent->getCell());
-    
-    while (!queue.isEmpty()) {
-        QPair<Cell*, int> current = queue.dequeue();
-        Cell* currentCell = current.first;
-        int currentDistance = current.second;
-        
-        if (currentDistance > 0 && !currentCell->isOccupied() && 
-            agent->canMoveThrough(currentCell->getType()) && 
-            !agent->canBePlacedOn(currentCell->getType())) {
-            currentCell->setBrush(QBrush(QColor(200, 200, 200, 100)));
-        }
-        
-        if (currentDistance < agent->getRemainingMoves()) {
-            QList<Cell*> neighbors = getAdjacentCells(currentCell);
-            for (Cell* neighbor : neighbors) {
-                if (!visited.contains(neighbor) && !neighbor->isOccupied() && 
-                    agent->canMoveThrough(neighbor->getType())) {
-                    visited.insert(neighbor);
-                    queue.enqueue({neighbor, currentDistance + 1});
-                }
-            }
+    GameRules::searchMoves(m_search, *m_board, agent->getType(), agent->getCell()->getIndex(),
+                           agent->getRemainingMoves(), [&](int cell) { return m_cells[cell]->isOccupied(); });
+    TM_PROFILE_COUNT(BfsNodes, m_search.settled().size());
+
+    for (int index : m_search.settled()) {
+        Cell* cell = m_cells[index];
+        if (cell != agent->getCell() && !agent->canBePlacedOn(cell->getType())) {
+            cell->setBrush(QBrush(QColor(200, 200, 200, 100)));
+            m_highlightedCells.append(cell);
+            TM_PROFILE_COUNT(BrushChanges, 1);
         }
     }
 }
 
 void GamePage::highlightAttackableEnemies(Agent* agent) {
+    TM_PROFILE_SCOPE(Highlight);
     if (!agent) return;
     
     // Get all cells within attack range
@@ -546,18 +789,30 @@ void GamePage::highlightAttackableEnemies(Agent* agent) {
     // Highlight enemy agents in attack range
     for (Cell* cell : attackRange) {
         if (Agent* enemy = cell->getAgent()) {
-            if (enemy->getOwner() != agent->getOwner()) {
+            if (enemy->getOwner() != agent->getOwner() && hasLineOfSight(agent->getCell(), cell)) {
                 enemy->setPen(QPen(Qt::red, 5));
+                TM_PROFILE_COUNT(BrushChanges, 1);
             }
         }
     }
 }
 
 void GamePage::clearAllHighlights() {
-    // Clear cell highlights
-    for (Cell* cell : m_cells) {
-        cell->resetBrush();
+    TM_PROFILE_SCOPE(ClearHighlights);
+    // Clear cell highlights: only the ones we made, once a full pass has
+    // dealt with whatever else coloured the board
+    if (m_highlightsUntracked) {
+        for (Cell* cell : m_cells) {
+            cell->resetBrush();
+        }
+        m_highlightsUntracked = false;
+    } else {
+        for (Cell* cell : m_highlightedCells) {
+            cell->resetBrush();
+        }
     }
+    m_highlightedCells.clear();
+    markChanged(HighlightsChanged);
     
     // Reset agent pen colors to normal
     for (Agent* agent : m_player1->getAgents()) {
@@ -571,3 +826,261 @@ void GamePage::clearAllHighlights() {
         }
     }
 }
+
+void GamePage::clearAgents() {
+    m_selectedAgent = nullptr;
+    m_history.clear();
+
+    for (Player* player : {m_player1, m_player2}) {
+        if (!player) continue;
+        for (Agent* agent : player->getAgents()) {
+            if (agent->scene()) {
+                agent->scene()->removeItem(agent);
+            }
+            delete agent;
+        }
+        player->clearAgents();
+    }
+
+    for (Cell* cell : m_cells) {
+        cell->setAgent(nullptr);
+    }
+
+    // The deleted agents' addresses may well come back for new ones
+    m_fog.clear();
+    m_fogViewerCells.clear();
+}
+
+QByteArray GamePage::saveSnapshot() const {
+    QVector<GameSnapshot::CellState> cells;
+    cells.reserve(m_cells.size());
+    for (Cell* cell : m_cells) {
+        GameSnapshot::CellState state;
+        state.row = cell->getRow();
+        state.col = cell->getCol();
+        state.type = cell->getType();
+        if (m_player1PlacementZones.contains(cell)) state.zone = 1;
+        else if (m_player2PlacementZones.contains(cell)) state.zone = 2;
+        cells.append(state);
+    }
+
+    // Agents are stored player 1 first, in the order they were placed
+    QVector<GameSnapshot::AgentState> agents;
+    for (Player* player : {m_player1, m_player2}) {
+        for (Agent* agent : player->getAgents()) {
+            GameSnapshot::AgentState state;
+            state.name = agent->getName();
+            state.owner = player->isPlayer1() ? 0 : 1;
+            state.type = agent->getType();
+            state.cellIndex = (agent->isAlive() && agent->getCell()) ? agent->getCell()->getIndex() : -1;
+            state.currentHP = agent->getCurrentHP();
+            state.maxHP = agent->getMaxHP();
+            state.mobility = agent->getMobility();
+            state.remainingMoves = agent->getRemainingMoves();
+            state.damage = agent->getDamage();
+            state.attackRange = agent->getAttackRange();
+            agents.append(state);
+        }
+    }
+
+    return GameSnapshot::write(m_mapName, m_currentPlayer == m_player1 ? 0 : 1,
+                               m_battlePhaseActive ? GameSnapshot::Battle : GameSnapshot::Placement,
+                               cells, agents, (m_lineOfSight ? GameSnapshot::LineOfSight : 0)
+                                              | (m_fogOfWar ? GameSnapshot::Fog : 0));
+}
+
+QSharedPointer<const HexBoard> GamePage::boardFor(const QString& mapName) const {
+    if (m_board && mapName == m_mapName) return m_board;
+    if (m_snapshotBoard && m_snapshotBoard->name() == mapName) return m_snapshotBoard;
+
+    // Generated maps travel by name, as with tm_server --map gen-<cells>
+    QSharedPointer<const HexBoard> board = MapGenerator::fromName(mapName);
+    if (!board) board = HexBoard::fromFile(":/new/prefix1/" + mapName, mapName);
+    m_snapshotBoard = board;
+    return board;
+}
+
+bool GamePage::checkSnapshot(const QByteArray& blob, QString* error) const {
+    GameSnapshot snapshot(blob);
+    if (!snapshot.isValid()) {
+        if (error) *error = snapshot.errorString();
+        return false;
+    }
+    QSharedPointer<const HexBoard> board = boardFor(snapshot.mapName());
+    if (!board || board->cellCount() == 0) {
+        if (error) *error = QString("cannot load map %1").arg(snapshot.mapName());
+        return false;
+    }
+    return snapshot.check(*board, error);
+}
+
+bool GamePage::restoreSnapshot(const QByteArray& blob) {
+    TM_TRACE_SPAN("restore snapshot", "game");
+
+    // Everything is checked before the current game is touched, so a
+    // snapshot that doesn't fit leaves it as it was. A snapshot taken on
+    // another map is checked against that map, loaded but not yet shown.
+    QString error;
+    if (!checkSnapshot(blob, &error)) {
+        TM_LOG_WARNING("Cannot restore snapshot: %1", error);
+        return false;
+    }
+    GameSnapshot snapshot(blob);
+    QSharedPointer<const HexBoard> board = boardFor(snapshot.mapName());
+    const bool otherMap = board != m_board;
+
+    m_animator->finishAll();
+    if (otherMap) {
+        const QSignalBlocker blocker(m_mapSelector);
+        m_mapSelector->setCurrentText(snapshot.mapName());
+        showBoard(board, snapshot.mapName());
+    } else {
+        clearAgents();
+    }
+
+    for (int i = 0; i < snapshot.agentCount(); ++i) {
+        const GameSnapshot::AgentRecord& record = snapshot.agent(i);
+        Player* owner = record.owner == 0 ? m_player1 : m_player2;
+
+        Agent* agent = new Agent(owner, snapshot.agentName(i), AgentType(record.type),
+                                 record.maxHP, record.mobility, record.damage, record.attackRange);
+        agent->restoreState(record.currentHP, record.remainingMoves);
+        owner->addAgent(agent);
+
+        if (record.cellIndex >= 0 && agent->isAlive()) {
+            agent->setCell(m_cells[record.cellIndex]);
+            addAgentItem(agent);
+        }
+    }
+
+    clearAllHighlights();
+    m_currentPlayer = snapshot.header().currentPlayer == 0 ? m_player1 : m_player2;
+    m_battlePhaseActive = snapshot.header().phase == GameSnapshot::Battle;
+    m_lineOfSight = snapshot.header().rules & GameSnapshot::LineOfSight;
+    m_fogOfWar = snapshot.header().rules & GameSnapshot::Fog;
+    rebuildFog();
+    rebuildThreats();
+    m_placementMode = false;
+    m_placableCells.clear();
+    m_currentPlacementCard = nullptr;
+    m_currentPlacementPlayer = -1;
+
+    markChanged(AllChanges);
+    return true;
+}
+
+QList<Agent*> GamePage::allAgents() const {
+    return m_player1->getAgents() + m_player2->getAgents();
+}
+
+Agent* GamePage::agentById(int agentId) const {
+    const int player1Count = m_player1->getAgents().size();
+    if (agentId < 0) return nullptr;
+    if (agentId < player1Count) return m_player1->getAgents().at(agentId);
+    agentId -= player1Count;
+    if (agentId < m_player2->getAgents().size()) return m_player2->getAgents().at(agentId);
+    return nullptr;
+}
+
+int GamePage::agentIdOf(Agent* agent) const {
+    const int index = m_player1->getAgents().indexOf(agent);
+    if (index >= 0) return index;
+    const int other = m_player2->getAgents().indexOf(agent);
+    return other >= 0 ? m_player1->getAgents().size() + other : -1;
+}
+
+void GamePage::beginRecording() {
+    m_recording.clear();
+    m_recordingPlayer = (m_currentPlayer == m_player1) ? 0 : 1;
+    m_recordingActive = true;
+}
+
+void GamePage::recordAgent(Agent* agent) {
+    if (!m_recordingActive || !agent) return;
+    const int id = agentIdOf(agent);
+    if (id < 0) return;
+    for (const AgentDelta& recorded : m_recording) {
+        if (recorded.agentId == id) return;   // Keep the state from before the first change
+    }
+
+    AgentDelta state;
+    state.agentId = id;
+    state.cellBefore = (agent->isAlive() && agent->getCell()) ? agent->getCell()->getIndex() : -1;
+    state.hpBefore = agent->getCurrentHP();
+    state.movesBefore = agent->getRemainingMoves();
+    m_recording.append(state);
+}
+
+GameDelta GamePage::endRecording() {
+    m_recordingActive = false;
+    GameDelta delta;
+    delta.playerBefore = m_recordingPlayer;
+    delta.playerAfter = (m_currentPlayer == m_player1) ? 0 : 1;
+
+    // Keep only the recorded agents that actually changed
+    for (AgentDelta state : m_recording) {
+        Agent* agent = agentById(state.agentId);
+        if (!agent) continue;
+        state.cellAfter = (agent->isAlive() && agent->getCell()) ? agent->getCell()->getIndex() : -1;
+        state.hpAfter = agent->getCurrentHP();
+        state.movesAfter = agent->getRemainingMoves();
+        if (state.cellAfter != state.cellBefore || state.hpAfter != state.hpBefore
+            || state.movesAfter != state.movesBefore) {
+            delta.agents.append(state);
+        }
+    }
+    return delta;
+}
+
+void GamePage::applyDelta(const GameDelta& delta, bool reverse) {
+    m_animator->finishAll();
+
+    // Lift every affected agent off the board first, so an agent moving into
+    // a cell another one is leaving cannot be cleared by that other agent
+    for (const AgentDelta& change : delta.agents) {
+        if (Agent* agent = agentById(change.agentId)) {
+            agent->setCell(nullptr);
+        }
+    }
+
+    for (const AgentDelta& change : delta.agents) {
+        Agent* agent = agentById(change.agentId);
+        if (!agent) continue;
+
+        const int cellIndex = reverse ? change.cellBefore : change.cellAfter;
+        agent->restoreState(reverse ? change.hpBefore : change.hpAfter,
+                            reverse ? change.movesBefore : change.movesAfter);
+
+        if (agent->isAlive() && cellIndex >= 0 && cellIndex < m_cells.size()) {
+            if (!agent->scene()) {
+                addAgentItem(agent);
+            }
+            agent->setCell(m_cells[cellIndex]);
+        } else if (agent->scene()) {
+            m_scene->removeItem(agent);
+        }
+    }
+
+    m_currentPlayer = ((reverse ? delta.playerBefore : delta.playerAfter) == 0) ? m_player1 : m_player2;
+    updateOverlays();
+}
+
+bool GamePage::undo() {
+    if (!m_battlePhaseActive || !m_history.canUndo()) return false;
+
+    m_selectedAgent = nullptr;
+    applyDelta(m_history.stepBack(), true);
+    clearAllHighlights();
+    markChanged(TurnChanged | SelectionChanged | AgentsChanged);
+    return true;
+}
+
+bool GamePage::redo() {
+    if (!m_battlePhaseActive || !m_history.canRedo()) return false;
+
+    m_selectedAgent = nullptr;
+    applyDelta(m_history.stepForward(), false);
+    clearAllHighlights();
+    markChanged(TurnChanged | SelectionChanged | AgentsChanged);
+    return true;
+}
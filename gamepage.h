@@ -5,15 +5,38 @@
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QComboBox>
+#include <QSharedPointer>
 #include "player.h"
 #include "Cell.h"
+#include "FogOfWar.h"
+#include "GameHistory.h"
+#include "GameRules.h"
+#include "Lockstep.h"
+#include "MoveCosts.h"
+#include "ThreatMap.h"
 
 class AgentCardWidget;
+class BoardNavigator;
+class HexBoard;
+class MoveAnimator;
+class ThreatOverlay;
 
 class GamePage : public QObject {
     Q_OBJECT
 
 public:
+    // What a gameStateChanged notification covers. Changes are collected
+    // and reported once per event loop iteration, however many actions ran.
+    enum Change {
+        TurnChanged = 0x01,         // Current player
+        SelectionChanged = 0x02,    // Selected agent
+        AgentsChanged = 0x04,       // Any agent's cell, HP or moves; agents added or removed
+        HighlightsChanged = 0x08,   // Cell brushes or agent pens
+        BoardChanged = 0x10,        // Another map, or the whole state replaced
+        AllChanges = 0x1f
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
     explicit GamePage(QComboBox* mapSelector, QGraphicsView* gameView,
                       Player* player1, Player* player2, QObject* parent = nullptr);
     ~GamePage();
@@ -37,16 +60,47 @@ public:
     void activateBattlePhase();
     void resetBattleState();
 
+    // Loads any map file; the map selector uses it for the bundled grids
+    void loadMap(const QString& path, const QString& mapName);
+
     // Accessors
     Player* currentPlayer() const;
     const QVector<Cell*>& getCells() const;
     Cell* getCellAt(int row, int col) const;
     
-    // BFS algorithms for hex grid
+    // Searches over the hex grid. With an agent, steps cost what MoveCosts
+    // says for its type and occupied cells block; without, every step costs one.
     QList<Cell*> getAdjacentCells(Cell* cell) const;
     QList<Cell*> getReachableCells(Cell* startCell, int maxDistance, Agent* agent = nullptr) const;
     QList<Cell*> getCellsInRange(Cell* centerCell, int range) const;
     int getBFSDistance(Cell* from, Cell* to, Agent* agent = nullptr) const;
+    QList<Cell*> getPath(Cell* from, Cell* to, Agent* agent = nullptr) const;   // from..to, empty if unreachable
+
+    // The rules of GameRules.h on the scene: what moving the agent to target
+    // costs (-1 if it can't) and, if asked, the cheapest path there;
+    // whether to is within range steps of from; and where an attacker that
+    // survives lands next to targetCell (null for nowhere). landingCell
+    // draws from the match's LockstepRandom.
+    int moveCost(Agent* agent, Cell* target, QList<Cell*>* path = nullptr) const;
+    bool isInRange(Cell* from, Cell* to, int range) const;
+    Cell* landingCell(Agent* attacker, Cell* targetCell);
+
+    // Optional rule: Rock blocks attacks. Always true while the rule is off.
+    void setLineOfSight(bool enabled);
+    bool lineOfSight() const { return m_lineOfSight; }
+    bool hasLineOfSight(Cell* from, Cell* to) const;
+
+    // Optional rule: fog of war (see FogOfWar.h). Cells the viewing player
+    // can't see are dimmed and enemy agents on them hidden; the viewer is
+    // the local player in network games, the current player otherwise.
+    void setFogOfWar(bool enabled);
+    bool fogOfWar() const { return m_fogOfWar; }
+
+    // Heat map of what the viewing player's enemies could hit next (see
+    // ThreatMap.h). Enemies hidden by the fog are left out. The map is only
+    // maintained while the overlay is shown.
+    void setThreatOverlay(bool enabled);
+    bool threatOverlay() const { return m_threatOverlayEnabled; }
     
     // Cell highlighting for movement and attacks
     void highlightMovementCells(Agent* agent);
@@ -54,29 +108,106 @@ public:
     void highlightAttackableEnemies(Agent* agent);
     void clearAllHighlights();
 
+    // Sprites slide along their path instead of jumping (see MoveAnimator.h)
+    void animateAgent(Agent* agent, const QList<Cell*>& path);
+    void setAnimatedMoves(bool enabled);
+
+    // Snapshot save/restore (see GameSnapshot.h). checkSnapshot says,
+    // without touching the game, whether restoreSnapshot would succeed.
+    QByteArray saveSnapshot() const;
+    bool checkSnapshot(const QByteArray& blob, QString* error = nullptr) const;
+    bool restoreSnapshot(const QByteArray& blob);
+    bool isBattlePhaseActive() const { return m_battlePhaseActive; }
+    QString currentMapName() const { return m_mapName; }
+
+    // Undo/redo of battle actions (see GameHistory.h)
+    bool canUndo() const { return m_history.canUndo(); }
+    bool canRedo() const { return m_history.canRedo(); }
+    bool undo();
+    bool redo();
+
+    // Delta recording, usable on its own to make/unmake moves in place.
+    // Only agents passed to recordAgent() between begin and end are looked
+    // at, so call it for every agent about to change; performAction and
+    // endTurn do for theirs.
+    QList<Agent*> allAgents() const;
+    Agent* agentById(int agentId) const;
+    int agentIdOf(Agent* agent) const;   // -1 if not on either roster
+    void beginRecording();
+    void recordAgent(Agent* agent);
+    GameDelta endRecording();
+    void applyDelta(const GameDelta& delta, bool reverse);
+
+    // Network play: the host (or a local game) validates and applies actions,
+    // a client forwards its clicks and applies the deltas it gets back
+    enum NetworkRole {
+        Local,
+        Host,
+        Client
+    };
+    void setNetworkRole(NetworkRole role, int localPlayer);
+    NetworkRole networkRole() const { return m_networkRole; }
+    bool isLocalTurn() const;
+    bool performAction(int fromCell, int toCell);
+    void applyRemoteDelta(const GameDelta& delta);
+
+    // Lockstep play: both peers apply every action themselves and compare a
+    // rolling checksum of the resulting state instead of shipping deltas
+    void startLockstep(quint32 seed);
+    bool isLockstep() const { return m_lockstep; }
+    quint32 checksum() const { return m_checksum; }
+    quint32 stateChecksum(quint32 previous) const;
+    bool applyLockstepAction(int fromCell, int toCell, quint32 expectedChecksum);
+
 signals:
     void cellClicked(Cell* cell);
+    void cellHovered(Cell* cell);   // Whenever the cell under the mouse changes, null for none
     void gameOver(Player* winner);
-    void gameStateChanged();
+    void gameStateChanged(GamePage::Changes changes);
+    void actionRequested(int fromCell, int toCell);
+    void actionApplied(const GameDelta& delta);
+    void localActionPerformed(int fromCell, int toCell, quint32 checksum);
 
 public slots:
     void onCellInteraction(Cell* cell);
 
 private slots:
     void loadSelectedMap(const QString &mapName);
+    void onBoardClicked(int index);
 
 private:
-    void loadMap(const QString& path);
+    void showBoard(QSharedPointer<const HexBoard> board, const QString& mapName);
+    QSharedPointer<const HexBoard> boardFor(const QString& mapName) const;
     Cell* createCell(int row, int col, const Cell::CellType type);
     void setupInitialAgents();
+    void clearAgents();
+    void addAgentItem(Agent* agent);
+    void markChanged(Changes changes);
+    void flushChanges();
+    int viewingPlayer() const;
+    void rebuildFog();
+    void updateFog();
+    void rebuildThreats();
+    void updateThreats();
+    void updateOverlays();
 
     bool m_placementMode;
     bool m_battlePhaseActive = false;  // Track if battle phase is active
+    bool m_lineOfSight = false;
+    bool m_fogOfWar = false;
+    bool m_threatOverlayEnabled = false;
 
     QGraphicsScene* m_scene;
+    MoveAnimator* m_animator;
     QGraphicsView* m_gameView;
+    BoardNavigator* m_navigator;   // Zoom, pan and level of detail
     QComboBox* m_mapSelector;
+    QString m_mapName;
+    QSharedPointer<const HexBoard> m_board;   // Immutable map data behind m_cells
+    mutable QSharedPointer<const HexBoard> m_snapshotBoard;   // Another map a snapshot was checked against
     QVector<Cell*> m_cells;
+    mutable MoveSearch m_search;   // Scratch space for the movement searches
+    mutable RangeSearch m_range;   // ... and for the attack range ones
     QList<Cell*> m_placableCells;
     QList<Cell*> m_player1PlacementZones;
     QList<Cell*> m_player2PlacementZones;
@@ -86,10 +217,47 @@ private:
 
     Agent* m_selectedAgent = nullptr;
     Cell* m_selectedCell = nullptr;
+
+    // Cells the highlight* functions changed, so clearing touches only those.
+    // Anything else may have recoloured cells (placement hints, a new map)
+    // until m_highlightsUntracked is cleared by a full pass.
+    QVector<Cell*> m_highlightedCells;
+    bool m_highlightsUntracked = true;
+
+    Changes m_pendingChanges;
+
+    // Fog of war: m_fog follows each agent's last known cell, m_fogShown is
+    // the visibility the cells were last drawn with (all visible when empty)
+    FogOfWar m_fog;
+    QHash<Agent*, int> m_fogViewerCells;
+    QVector<quint64> m_fogShown;
+
+    // Threat overlay: m_threatViewer is the player the overlay was last
+    // drawn for, -1 when it needs a full redraw
+    ThreatMap m_threats;
+    ThreatOverlay* m_threatOverlay = nullptr;   // Owned by the scene
+    int m_threatViewer = -1;
+
+    // Undo/redo
+    GameHistory m_history;
+    QVector<AgentDelta> m_recording;   // "before" half of the delta being recorded
+    int m_recordingPlayer = 0;
+    bool m_recordingActive = false;
+
+    // Network play
+    NetworkRole m_networkRole = Local;
+    int m_localPlayer = -1;   // -1 = both players at this machine
+
+    // Lockstep
+    LockstepRandom m_random;   // The only source of randomness in the rules
+    bool m_lockstep = false;
+    quint32 m_checksum = 0;
     
     // Placement state
     AgentCardWidget* m_currentPlacementCard = nullptr;
     int m_currentPlacementPlayer = -1;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(GamePage::Changes)
+
 #endif // GAMEPAGE_H
@@ -0,0 +1,135 @@
+// loadgen_main.cpp - Load generator for tm_server
+//
+//   tm_loadgen --host 127.0.0.1 --port 45454 --matches 500 --cores 8
+//
+// Opens two bot clients per match, lets them play to the end and reports
+// per-action latency percentiles and match throughput.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include "HexBoard.h"
+#include "LoadClient.h"
+#include "Log.h"
+#include "MapGenerator.h"
+#include "NetworkSession.h"
+#include "TraceRecorder.h"
+
+static qint64 percentile(const QVector<qint64>& sorted, double fraction) {
+    if (sorted.isEmpty()) return 0;
+    const int index = qBound(0, int(fraction * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return sorted[index];
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    Log::installFlushTimer();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Tactical Monster load generator");
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Server address.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "Server port.", "port", QString::number(NetworkSession::DefaultPort));
+    QCommandLineOption matchesOption("matches", "Concurrent matches to play (two clients each).", "count", "100");
+    QCommandLineOption coresOption("cores", "Server threads, for the per-core figure.", "count",
+                                   QString::number(QThread::idealThreadCount()));
+    QCommandLineOption timeoutOption("timeout", "Give up after this many seconds.", "seconds", "120");
+    QCommandLineOption traceOption("trace", "Record a Chrome trace of the run to <file>.", "file");
+    QCommandLineOption mapOption("map", "Generated map the server plays (gen-<cells>[-<seed>]); may be repeated.", "map");
+    parser.addOption(hostOption);
+    parser.addOption(portOption);
+    parser.addOption(matchesOption);
+    parser.addOption(coresOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(traceOption);
+    parser.addOption(mapOption);
+    parser.process(app);
+
+    const QString tracePath = parser.value(traceOption);
+    if (!tracePath.isEmpty()) {
+        TraceRecorder::instance().start();
+    }
+
+    // Bots keep a local mirror of the match, so they need the same maps
+    QHash<QString, QSharedPointer<const HexBoard>> boards;
+    for (int i = 1; i <= 8; ++i) {
+        const QString name = QString("grid%1.txt").arg(i);
+        boards.insert(name, HexBoard::fromFile(":/new/prefix1/" + name, name));
+    }
+    for (const QString& name : parser.values(mapOption)) {
+        QSharedPointer<const HexBoard> board = MapGenerator::fromName(name);
+        if (!board) {
+            qCritical() << "Not a generated map name:" << name;
+            return 1;
+        }
+        boards.insert(name, board);
+    }
+
+    const QString host = parser.value(hostOption);
+    const quint16 port = quint16(parser.value(portOption).toUInt());
+    const int clientCount = 2 * qMax(1, parser.value(matchesOption).toInt());
+    const int cores = qMax(1, parser.value(coresOption).toInt());
+
+    QVector<LoadClient*> clients;
+    int running = clientCount;
+    QElapsedTimer wallClock;
+    wallClock.start();
+
+    auto report = [&]() {
+        const double seconds = wallClock.nsecsElapsed() / 1e9;
+        QVector<qint64> latencies;
+        int gameOver = 0;
+        int stalled = 0;
+        int dropped = 0;
+        for (const LoadClient* client : clients) {
+            latencies += client->latencies();
+            switch (client->outcome()) {
+            case LoadClient::GameOver: ++gameOver; break;
+            case LoadClient::Stalled: ++stalled; break;
+            default: ++dropped; break;
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        // Both clients of a finished match count it, hence the halving
+        const double matches = gameOver / 2.0;
+        const double matchesPerSecond = seconds > 0 ? matches / seconds : 0;
+        qInfo().noquote() << QString("clients=%1 finished=%2 stalled=%3 dropped=%4")
+                             .arg(clientCount).arg(gameOver).arg(stalled).arg(dropped);
+        qInfo().noquote() << QString("actions=%1 latency_us p50=%2 p90=%3 p99=%4 max=%5")
+                             .arg(latencies.size())
+                             .arg(percentile(latencies, 0.50))
+                             .arg(percentile(latencies, 0.90))
+                             .arg(percentile(latencies, 0.99))
+                             .arg(latencies.isEmpty() ? 0 : latencies.last());
+        qInfo().noquote() << QString("elapsed_s=%1 matches=%2 matches_per_s=%3 matches_per_s_per_core=%4")
+                             .arg(seconds, 0, 'f', 3).arg(matches)
+                             .arg(matchesPerSecond, 0, 'f', 2)
+                             .arg(matchesPerSecond / cores, 0, 'f', 2);
+        if (TraceRecorder::isRecording()) {
+            TraceRecorder::instance().stop(tracePath);
+        }
+        app.quit();
+    };
+
+    for (int i = 0; i < clientCount; ++i) {
+        LoadClient* client = new LoadClient(i, boards, &app);
+        clients.append(client);
+        QObject::connect(client, &LoadClient::finished, &app, [&]() {
+            if (--running == 0) report();
+        });
+
+        // Connect in batches so the server's listen backlog is not flooded
+        QTimer::singleShot((i / 64) * 10, client, [client, host, port]() {
+            client->start(host, port);
+        });
+    }
+
+    QTimer::singleShot(parser.value(timeoutOption).toInt() * 1000, &app, report);
+
+    return app.exec();
+}
@@ -28,6 +28,10 @@ void Player::removeAgent(Agent* agent) {
     m_agents.removeOne(agent);
 }
 
+void Player::clearAgents() {
+    m_agents.clear();
+}
+
 void Player::startTurn() {
     for (Agent* agent : m_agents) {
         if (agent->isAlive()) {
@@ -22,6 +22,7 @@ public:
     // Agent management
     void addAgent(Agent* agent);
     void removeAgent(Agent* agent);
+    void clearAgents();
 
     // Game actions
     void startTurn();
@@ -0,0 +1,97 @@
+// server_main.cpp - Headless multi-match server
+//
+//   tm_server --port 45454 --threads 8 --map all
+//
+// Clients (the game's "Join Online", or tm_loadgen) are paired in arrival
+// order; each pair plays one match on one of the server threads.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+#include "GameSnapshot.h"
+#include "HexBoard.h"
+#include "Log.h"
+#include "MapGenerator.h"
+#include "MapValidator.h"
+#include "MatchServer.h"
+#include "NetworkSession.h"
+#include "TraceRecorder.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    Log::installFlushTimer();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Tactical Monster headless match server");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "TCP port to listen on.", "port", QString::number(NetworkSession::DefaultPort));
+    QCommandLineOption threadsOption("threads", "Event loop threads (default: one per core).", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption mapOption("map", "Map to play (gridN.txt or a generated gen-<cells>[-<seed>]), or \"all\" "
+                                 "to rotate through every bundled map.", "map", "all");
+    QCommandLineOption lineOfSightOption("line-of-sight", "Play with the line of sight rule (Rock blocks attacks).");
+    QCommandLineOption fogOption("fog-of-war", "Play with fog of war (agents only see nearby cells).");
+    QCommandLineOption statsOption("stats", "Seconds between statistics lines (0 = off).", "seconds", "5");
+    QCommandLineOption traceOption("trace", "Record a Chrome trace to <file>.", "file");
+    QCommandLineOption traceSecondsOption("trace-seconds", "Length of the --trace recording.", "seconds", "10");
+    parser.addOption(portOption);
+    parser.addOption(threadsOption);
+    parser.addOption(mapOption);
+    parser.addOption(lineOfSightOption);
+    parser.addOption(fogOption);
+    parser.addOption(statsOption);
+    parser.addOption(traceOption);
+    parser.addOption(traceSecondsOption);
+    parser.process(app);
+
+    // Maps are parsed once and shared read-only by every match
+    QStringList mapNames;
+    if (parser.value(mapOption) == "all") {
+        for (int i = 1; i <= 8; ++i) mapNames << QString("grid%1.txt").arg(i);
+    } else {
+        mapNames << parser.value(mapOption);
+    }
+
+    QVector<QSharedPointer<const HexBoard>> boards;
+    for (const QString& name : mapNames) {
+        QSharedPointer<const HexBoard> board = MapGenerator::fromName(name);
+        if (!board) board = HexBoard::fromFile(":/new/prefix1/" + name, name);
+        if (!board || board->cellCount() == 0) {
+            qCritical() << "Cannot load map" << name;
+            return 1;
+        }
+        MapValidator::logProblems(*board);
+        boards.append(board);
+    }
+
+    const int rules = (parser.isSet(lineOfSightOption) ? GameSnapshot::LineOfSight : 0)
+                      | (parser.isSet(fogOption) ? GameSnapshot::Fog : 0);
+    MatchServer server(parser.value(threadsOption).toInt(), boards, rules);
+    const quint16 port = quint16(parser.value(portOption).toUInt());
+    if (!server.listen(QHostAddress::Any, port)) {
+        qCritical() << "Cannot listen on port" << port << ":" << server.errorString();
+        return 1;
+    }
+    qInfo() << "Listening on port" << port << "with" << server.threadCount() << "threads and"
+            << boards.size() << "maps";
+
+    QTimer statsTimer;
+    const int statsSeconds = parser.value(statsOption).toInt();
+    if (statsSeconds > 0) {
+        QObject::connect(&statsTimer, &QTimer::timeout, &server, &MatchServer::printStats);
+        statsTimer.start(statsSeconds * 1000);
+    }
+
+    // The server runs until killed, so a trace covers a fixed window instead
+    if (parser.isSet(traceOption)) {
+        const QString tracePath = parser.value(traceOption);
+        TraceRecorder::instance().start();
+        QTimer::singleShot(parser.value(traceSecondsOption).toInt() * 1000, &server, [tracePath]() {
+            TraceRecorder::instance().stop(tracePath);
+        });
+    }
+
+    return app.exec();
+}
@@ -2,15 +2,29 @@
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QMovie>
+#include <QShortcut>
+#include <QFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QRandomGenerator>
 #include <qmessagebox.h>
+#include <QTimer>
+#include "AssetLoader.h"
+#include "GameSnapshot.h"
 #include "AgentCardWidget.h"
 #include "AgentType.h"
+#include "AgentRoster.h"
+#include "Log.h"
+#include "ProfilerOverlay.h"
+#include "TraceRecorder.h"
+#include <QDateTime>
 
 TacticalMonster::TacticalMonster(QWidget *parent) : QMainWindow(parent), ui(new Ui::TacticalMonster)
 {
     ui->setupUi(this);
     setupUI();
-    setupAgentSelection();
+    setupNetworkControls();
+    // Agent cards are made when the first match starts (see startMatch)
 }
 
 TacticalMonster::~TacticalMonster()
@@ -24,6 +38,9 @@ TacticalMonster::~TacticalMonster()
 
 void TacticalMonster::setupAgentSelection()
 {
+    if (m_agentCardsCreated) return;
+    m_agentCardsCreated = true;
+
     // Clear existing cards
     qDeleteAll(ui->player1CardsLayout->children());
     qDeleteAll(ui->player2CardsLayout->children());
@@ -36,38 +53,7 @@ void TacticalMonster::setupAgentSelection()
 
 void TacticalMonster::createAgentCards()
 {
-    struct AgentDef {
-        QString name;
-        AgentType type;
-        int hp, mobility, damage, attackRange;
-    };
-
-    QList<AgentDef> agents = {
-        {"Sir Lamorak", Grounded, 320, 3, 110, 1},
-        {"Kabul", Grounded, 400, 2, 120, 1},
-        {"Rajakal", Grounded, 320, 2, 130, 1},
-        {"Salih", Grounded, 400, 2, 80, 1},
-        {"Khan", Grounded, 320, 2, 90, 1},
-        {"Boi", Grounded, 400, 2, 100, 1},
-        {"Eloi", Grounded, 240, 2, 100, 2},
-        {"Kanar", Grounded, 160, 2, 100, 2},
-        {"Elsa", Grounded, 320, 2, 140, 2},
-        {"Karissa", Grounded, 280, 2, 80, 2},
-        {"Sir Philip", Grounded, 400, 2, 100, 1},
-        {"Frost", Grounded, 260, 2, 80, 2},
-        {"Tusk", Grounded, 400, 2, 100, 1},
-        {"Rambu", Flying, 320, 3, 120, 1},
-        {"Sabrina", Floating, 320, 3, 100, 1},
-        {"Death", Floating, 240, 3, 120, 2},
-        {"Reketon", WaterWalking, 320, 2, 80, 2},
-        {"Angus", WaterWalking, 400, 2, 100, 1},
-        {"Duraham", WaterWalking, 320, 2, 100, 2},
-        {"Colonel Baba", WaterWalking, 400, 2, 100, 1},
-        {"Medusa", WaterWalking, 320, 2, 90, 2},
-        {"Bunka", WaterWalking, 320, 3, 100, 1},
-        {"Sanka", WaterWalking, 320, 3, 100, 1},
-        {"Billy", WaterWalking, 320, 3, 90, 1}
-    };
+    const QVector<AgentDef>& agents = AgentRoster::all();
 
     for (const auto& agent : agents)
     {
@@ -83,7 +69,7 @@ void TacticalMonster::createAgentCards()
         AgentCardWidget* card2 = new AgentCardWidget(agent.name, agent.type, agent.hp,
                                                         agent.mobility, agent.damage, agent.attackRange);
         connect(card2, &AgentCardWidget::clicked, [this, card2]() {
-            qDebug() << "Player 2 card clicked - calling onAgentCardClicked";
+            TM_LOG_DEBUG("Player 2 card clicked - calling onAgentCardClicked");
             onAgentCardClicked(card2, 1);
         });
         ui->player2CardsLayout->insertWidget(0,card2);
@@ -91,20 +77,24 @@ void TacticalMonster::createAgentCards()
 }
 
 void TacticalMonster::onAgentCardClicked(AgentCardWidget* card, int playerIndex) {
-    qDebug() << "Card clicked:" << card->getName() << "Player:" << playerIndex;
-    qDebug() << "Current widget:" << (ui->stackedWidget->currentWidget() == ui->PreCombat_Page ? "PreCombat_Page" : "Other");
-    qDebug() << "Current phase:" << m_currentPhase;
+    TM_LOG_DEBUG("Card clicked: %1 Player: %2 Current widget: %3 Current phase: %4", card->getName(), playerIndex,
+                 ui->stackedWidget->currentWidget() == ui->PreCombat_Page ? "PreCombat_Page" : "Other", m_currentPhase);
+    
+    // In a network game each side only places its own agents
+    if (m_localPlayer >= 0 && playerIndex != m_localPlayer) {
+        return;
+    }
     
     // Only handle clicks in PreCombat page during placement phase
     if (ui->stackedWidget->currentWidget() == ui->PreCombat_Page && m_currentPhase == AgentPlacement) {
         QList<AgentCardWidget*>& placedCards = (playerIndex == 0) ? m_player1PlacedCards : m_player2PlacedCards;
         
-        qDebug() << "Player" << playerIndex << "placed cards count:" << placedCards.size();
-        qDebug() << "Card is already placed:" << placedCards.contains(card);
+        TM_LOG_DEBUG("Player %1 placed cards count: %2, card is already placed: %3",
+                     playerIndex, placedCards.size(), placedCards.contains(card));
         
         // Check if this card is currently selected (deselection case)
         if (m_currentPlacementCard == card && m_currentPlacementPlayer == playerIndex) {
-            qDebug() << "Deselecting card:" << card->getName();
+            TM_LOG_DEBUG("Deselecting card: %1", card->getName());
             
             // Clear highlights and reset selection
             clearCellHighlights();
@@ -115,7 +105,7 @@ void TacticalMonster::onAgentCardClicked(AgentCardWidget* card, int playerIndex)
         
         // Only allow placement if this card hasn't been placed yet and player has less than 3 placed
         if (!placedCards.contains(card) && placedCards.size() < 3) {
-            qDebug() << "Starting placement for card:" << card->getName();
+            TM_LOG_DEBUG("Starting placement for card: %1", card->getName());
             
             // Clear previous highlights
             clearCellHighlights();
@@ -127,9 +117,9 @@ void TacticalMonster::onAgentCardClicked(AgentCardWidget* card, int playerIndex)
             // Highlight valid cells for this player
             highlightValidCells(playerIndex);
         } else if (placedCards.contains(card)) {
-            qDebug() << "Card already placed!";
+            TM_LOG_DEBUG("Card already placed!");
         } else {
-            qDebug() << "Player already has 3 agents placed!";
+            TM_LOG_DEBUG("Player already has 3 agents placed!");
         }
     }
 }
@@ -139,9 +129,9 @@ void TacticalMonster::updateSelectionStatus() {
 }
 
 void TacticalMonster::on_OKButton_clicked() {
-    qDebug() << "=== OK Button Clicked ===";
-    qDebug() << "Before transition - Player1 selected:" << m_player1SelectedCards.size() 
-             << "Player2 selected:" << m_player2SelectedCards.size();
+    TM_LOG_DEBUG("=== OK Button Clicked ===");
+    TM_LOG_DEBUG("Before transition - Player1 selected: %1 Player2 selected: %2",
+                 m_player1SelectedCards.size(), m_player2SelectedCards.size());
              
     QString name1 = ui->Player1_LineEdit->text();
     QString name2 = ui->Player2_LineEdit->text();
@@ -151,35 +141,91 @@ void TacticalMonster::on_OKButton_clicked() {
         return;
     }
 
+    startMatch(name1, name2);
+    
+    TM_LOG_DEBUG("=== Transition Complete ===");
+}
+
+void TacticalMonster::startMatch(const QString& name1, const QString& name2) {
     delete m_gamePage;
     m_player1 = new Player(name1, true, this);
     m_player2 = new Player(name2, false, this);
 
     m_gamePage = new GamePage(ui->MapSelector_CBox, ui->GameView_GView,
                               m_player1, m_player2, this);
+    m_gamePage->setLineOfSight(m_lineOfSightCheck->isChecked());
+    m_gamePage->setFogOfWar(m_fogOfWarCheck->isChecked());
+    m_gamePage->setThreatOverlay(m_showThreats);
     
     // Connect cell interaction signals
     connect(m_gamePage, &GamePage::cellClicked, this, &TacticalMonster::onCellClicked);
     
+    // Network play: the host broadcasts every applied action, a client
+    // forwards its clicks and lets the host decide
+    if (m_network && m_network->role() == NetworkSession::Host) {
+        m_gamePage->setNetworkRole(GamePage::Host, m_localPlayer);
+        connect(m_gamePage, &GamePage::actionApplied, m_network, [this](const GameDelta& delta) {
+            if (!m_gamePage->isLockstep()) m_network->sendDelta(delta);
+        });
+        
+        // The host's map choice is part of the shared state. Connected after
+        // GamePage's own handler so the new map is loaded before it is sent.
+        connect(ui->MapSelector_CBox, &QComboBox::currentTextChanged, m_gamePage, [this]() { sendStateToPeer(); });
+    } else if (m_network && m_network->role() == NetworkSession::Client) {
+        m_gamePage->setNetworkRole(GamePage::Client, m_localPlayer);
+        connect(m_gamePage, &GamePage::actionRequested, m_network, &NetworkSession::sendAction);
+    }
+    if (m_network && m_network->role() != NetworkSession::Offline) {
+        // Lockstep: our own actions go out with the checksum we ended up with
+        connect(m_gamePage, &GamePage::localActionPerformed, m_network,
+                [this](int fromCell, int toCell, quint32 checksum) {
+            if (m_gamePage->isLockstep()) m_network->sendLockstepAction(fromCell, toCell, checksum);
+        });
+    }
+    ui->MapSelector_CBox->setEnabled(!isNetworkClient());
+    
+    setupAgentSelection();
     m_gamePage->startGame();
     
-    qDebug() << "Before setupCombatPage - Player1 selected:" << m_player1SelectedCards.size() 
-             << "Player2 selected:" << m_player2SelectedCards.size();
+    TM_LOG_DEBUG("Before setupCombatPage - Player1 selected: %1 Player2 selected: %2",
+                 m_player1SelectedCards.size(), m_player2SelectedCards.size());
     
     setupCombatPage();
     ui->stackedWidget->setCurrentWidget(ui->PreCombat_Page);
-    
-    qDebug() << "=== Transition Complete ===";
 }
 
 void TacticalMonster::setupUI() {
-    // Setup animations and fonts
-    QMovie *movie = new QMovie(":/new/prefix1/animation.gif");
-    ui->BackGround_Label->setMovie(movie);
-    movie->start();
-
     ui->stackedWidget->setCurrentWidget(ui->Welcome_Page);
 
+    // Pictures are set when their page is first shown (see AssetLoader.h),
+    // so none is decoded before the first frame. The background labels are
+    // 881x711 and get Background3 at that size; the pre-combat page's style
+    // sheet uses the original
+    const QString background = AssetLoader::scaledPath(":/new/prefix1/Background3.jpg", QSize(881, 711));
+    m_pageImages = {
+        {ui->MainMenu_Page, ui->BackGround_Label_2, background},
+        {ui->MainMenu_Page, ui->markLabel, ":/new/prefix1/markGame2.jpg"},
+        {ui->GalleryMain_Page, ui->BackGround_Label_3, background},
+        {ui->GalleryFlying_Page, ui->BackGround_Label_7, background},
+        {ui->GalleryFloating_Page, ui->BackGround_Label_8, background},
+        {ui->GalleryWaterWalking_Page, ui->BackGround_Label_6, background},
+        {ui->GalleryGrounded_Page, ui->BackGround_Label_4, background},
+        {ui->CreatServer_Page, ui->BackGround_Label_5, ":/new/prefix1/page2Background.jpg"},
+        {ui->CreatServer_Page, ui->markLabel_2, ":/new/prefix1/markGame2.jpg"},
+    };
+    connect(ui->stackedWidget, &QStackedWidget::currentChanged, this, [this](int index) {
+        loadPageImages(ui->stackedWidget->widget(index));
+    });
+
+    // The welcome animation starts once the window is up; the main menu,
+    // the only way on from the welcome page, is decoded in the meantime
+    QTimer::singleShot(0, this, [this]() {
+        QMovie* movie = new QMovie(":/new/prefix1/animation.gif", QByteArray(), ui->BackGround_Label);
+        ui->BackGround_Label->setMovie(movie);
+        movie->start();
+        loadPageImages(ui->MainMenu_Page);
+    });
+
     // Connect navigation buttons
     connect(ui->Play_Btn, &QPushButton::clicked, [this]() {ui->stackedWidget->setCurrentWidget(ui->MainMenu_Page);});
     connect(ui->Gallery_Btn, &QPushButton::clicked, [this]() {ui->stackedWidget->setCurrentWidget(ui->GalleryMain_Page);});
@@ -199,6 +245,63 @@ void TacticalMonster::setupUI() {
     connect(ui->Back_Btn_WaterWalkingGallery, &QPushButton::clicked, this, &TacticalMonster::handleNavigation);
     connect(ui->Back_Btn_CreateServer, &QPushButton::clicked, this, &TacticalMonster::handleNavigation);
     connect(ui->Back_Btn_PreCombat, &QPushButton::clicked, this, &TacticalMonster::handleNavigation);
+
+    // Optional rules, chosen with the map; a network host's choice reaches
+    // the other side in its snapshots
+    m_lineOfSightCheck = new QCheckBox("Rock blocks line of sight", ui->PreCombat_Page);
+    m_lineOfSightCheck->setGeometry(630, 20, 191, 24);
+    connect(m_lineOfSightCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        if (m_gamePage) m_gamePage->setLineOfSight(checked);
+    });
+    m_fogOfWarCheck = new QCheckBox("Fog of war", ui->PreCombat_Page);
+    m_fogOfWarCheck->setGeometry(630, 46, 191, 24);
+    connect(m_fogOfWarCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        if (m_gamePage) m_gamePage->setFogOfWar(checked);
+    });
+
+    // Quick save / quick load
+    QShortcut* saveShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_S), this);
+    connect(saveShortcut, &QShortcut::activated, this, &TacticalMonster::saveGame);
+    QShortcut* loadShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_L), this);
+    connect(loadShortcut, &QShortcut::activated, this, &TacticalMonster::loadGame);
+
+    // Undo / redo of battle actions
+    QShortcut* undoShortcut = new QShortcut(QKeySequence::Undo, this);
+    connect(undoShortcut, &QShortcut::activated, this, &TacticalMonster::undoAction);
+    QShortcut* redoShortcut = new QShortcut(QKeySequence::Redo, this);
+    connect(redoShortcut, &QShortcut::activated, this, &TacticalMonster::redoAction);
+
+    // Ctrl+T starts/stops a Chrome trace recording; paints of the board are spans too
+    QShortcut* traceShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_T), this);
+    connect(traceShortcut, &QShortcut::activated, this, &TacticalMonster::toggleTraceRecording);
+    ui->GameView_GView->viewport()->installEventFilter(new TracePaintFilter(this));
+
+    // F6 shows where the enemy could strike next (see ThreatOverlay.h)
+    QShortcut* threatShortcut = new QShortcut(QKeySequence(Qt::Key_F6), this);
+    connect(threatShortcut, &QShortcut::activated, this, [this]() {
+        m_showThreats = !m_showThreats;
+        if (m_gamePage) m_gamePage->setThreatOverlay(m_showThreats);
+    });
+
+#ifdef TM_PROFILING
+    // Per-click timing breakdown and paint statistics over the board (see
+    // Profiler.h); F4 and F5 switch the view's update and cache modes
+    ProfilerOverlay* profilerOverlay = new ProfilerOverlay(ui->GameView_GView);
+    QShortcut* profilerShortcut = new QShortcut(QKeySequence(Qt::Key_F3), this);
+    connect(profilerShortcut, &QShortcut::activated, profilerOverlay, &ProfilerOverlay::toggle);
+    QShortcut* updateModeShortcut = new QShortcut(QKeySequence(Qt::Key_F4), this);
+    connect(updateModeShortcut, &QShortcut::activated, profilerOverlay, &ProfilerOverlay::cycleUpdateMode);
+    QShortcut* cacheShortcut = new QShortcut(QKeySequence(Qt::Key_F5), this);
+    connect(cacheShortcut, &QShortcut::activated, profilerOverlay, &ProfilerOverlay::cycleCacheSetting);
+#endif
+}
+
+void TacticalMonster::loadPageImages(QWidget* page) {
+    for (int i = m_pageImages.size() - 1; i >= 0; --i) {
+        if (m_pageImages[i].page != page) continue;
+        AssetLoader::loadPixmap(m_pageImages[i].label, m_pageImages[i].path);
+        m_pageImages.remove(i);
+    }
 }
 
 void TacticalMonster::handleNavigation()
@@ -227,7 +330,7 @@ void TacticalMonster::handleNavigation()
 }
 
 void TacticalMonster::setupCombatPage() {
-    qDebug() << "Setting up combat page";
+    TM_LOG_DEBUG("Setting up combat page");
     
     // Start directly in placement mode
     m_currentPhase = AgentPlacement;
@@ -251,12 +354,12 @@ void TacticalMonster::setupCombatPage() {
     // Update UI for placement phase
     updatePlacementStatus();
     
-    qDebug() << "Combat page setup complete, current phase:" << m_currentPhase;
+    TM_LOG_DEBUG("Combat page setup complete, current phase: %1", m_currentPhase);
 }
 
 void TacticalMonster::updatePlacementStatus() {
-    qDebug() << "updatePlacementStatus - Player1 placed:" << m_player1PlacedCards.size() 
-             << "Player2 placed:" << m_player2PlacedCards.size();
+    TM_LOG_DEBUG("updatePlacementStatus - Player1 placed: %1 Player2 placed: %2",
+                 m_player1PlacedCards.size(), m_player2PlacedCards.size());
              
     ui->player1Status_Label->setText(
         QString("Placed: %1/3").arg(m_player1PlacedCards.size()));
@@ -275,10 +378,13 @@ void TacticalMonster::updatePlacementStatus() {
     }
     
     // Enable start battle button when all 6 agents are placed
-    if (m_player1PlacedCards.size() == 3 && m_player2PlacedCards.size() == 3) {
+    if (isNetworkClient()) {
+        ui->StartBattle_Btn->setText("Waiting for host");
+        ui->StartBattle_Btn->setEnabled(false);
+    } else if (m_player1PlacedCards.size() == 3 && m_player2PlacedCards.size() == 3) {
         ui->StartBattle_Btn->setText("Start Battle");
         ui->StartBattle_Btn->setEnabled(true);
-        qDebug() << "All agents placed - battle can start!";
+        TM_LOG_DEBUG("All agents placed - battle can start!");
     } else {
         ui->StartBattle_Btn->setText(QString("Place All Agents (%1/6)")
                                     .arg(m_player1PlacedCards.size() + m_player2PlacedCards.size()));
@@ -288,13 +394,19 @@ void TacticalMonster::updatePlacementStatus() {
 
 void TacticalMonster::onCellClicked(Cell* cell) {
     if (m_currentPhase == AgentPlacement && m_currentPlacementCard && m_gamePage) {
-        qDebug() << "Cell clicked during placement phase";
+        TM_LOG_DEBUG("Cell clicked during placement phase");
         
         // Try to place the agent
         QList<Cell*> validCells = m_gamePage->getValidPlacementCells(m_currentPlacementPlayer);
         
-        if (validCells.contains(cell) && !cell->isOccupied()) {
-            qDebug() << "Placing agent" << m_currentPlacementCard->getName() << "on valid cell";
+        if (validCells.contains(cell) && !cell->isOccupied() && isNetworkClient()) {
+            // The host places the agent and sends the new state back
+            m_network->sendPlace(m_currentPlacementCard->getName(), cell->getIndex());
+            clearCellHighlights();
+            m_currentPlacementCard = nullptr;
+            m_currentPlacementPlayer = -1;
+        } else if (validCells.contains(cell) && !cell->isOccupied()) {
+            TM_LOG_DEBUG("Placing agent %1 on valid cell", m_currentPlacementCard->getName());
             
             // Place the agent
             if (m_gamePage->placeAgent(m_currentPlacementCard, cell, m_currentPlacementPlayer)) {
@@ -305,8 +417,8 @@ void TacticalMonster::onCellClicked(Cell* cell) {
                     m_player2PlacedCards.append(m_currentPlacementCard);
                 }
                 
-                qDebug() << "Agent placed successfully! Total placed: Player1=" 
-                         << m_player1PlacedCards.size() << "Player2=" << m_player2PlacedCards.size();
+                TM_LOG_DEBUG("Agent placed successfully! Total placed: Player1=%1 Player2=%2",
+                             m_player1PlacedCards.size(), m_player2PlacedCards.size());
                 
                 // Clear placement state and highlights
                 clearCellHighlights();
@@ -315,17 +427,18 @@ void TacticalMonster::onCellClicked(Cell* cell) {
                 
                 // Update UI
                 updatePlacementStatus();
+                sendStateToPeer();
             }
         } else {
-            qDebug() << "Invalid cell clicked - not in valid cells or occupied";
+            TM_LOG_DEBUG("Invalid cell clicked - not in valid cells or occupied");
         }
     } else if (m_currentPhase == Battle) {
         // Handle battle phase cell interactions
         // This will be handled by the GamePage's existing logic
-        qDebug() << "Cell clicked during battle phase - letting GamePage handle it";
+        TM_LOG_DEBUG("Cell clicked during battle phase - letting GamePage handle it");
     } else {
         // During other phases, don't allow any interactions
-        qDebug() << "Cell clicked but no valid action for current phase:" << m_currentPhase;
+        TM_LOG_DEBUG("Cell clicked but no valid action for current phase: %1", m_currentPhase);
     }
 }
 
@@ -339,6 +452,7 @@ void TacticalMonster::onAgentPlaced(int playerIndex) {
 void TacticalMonster::onStartBattleClicked() {
     if (m_player1PlacedCards.size() == 3 && m_player2PlacedCards.size() == 3) {
         startBattlePhase();
+        sendStateToPeer();
     }
 }
 
@@ -380,8 +494,9 @@ void TacticalMonster::startBattlePhase() {
                                    QString("Game Over! Winner: %1").arg(winnerName));
         });
         
-        connect(m_gamePage, &GamePage::gameStateChanged, this, [this]() {
-            // Update UI based on game state changes during battle
+        connect(m_gamePage, &GamePage::gameStateChanged, this, [this](GamePage::Changes changes) {
+            // Only the turn shows in the labels; selections and moves don't
+            if (!(changes & (GamePage::TurnChanged | GamePage::BoardChanged))) return;
             if (m_gamePage->currentPlayer()) {
                 QString currentPlayerName = m_gamePage->currentPlayer()->getName();
                 ui->player1Status_Label->setText(
@@ -399,18 +514,18 @@ void TacticalMonster::startBattlePhase() {
     
     // Start the actual battle
     // The GamePage will handle the battle logic
-    qDebug() << "Battle phase started!";
+    TM_LOG_DEBUG("Battle phase started!");
 }
 
 void TacticalMonster::highlightValidCells(int playerIndex) {
-    qDebug() << "highlightValidCells called for player:" << playerIndex;
+    TM_LOG_DEBUG("highlightValidCells called for player: %1", playerIndex);
     
     if (m_gamePage) {
         QList<Cell*> validCells = m_gamePage->getValidPlacementCells(playerIndex);
-        qDebug() << "Valid cells found:" << validCells.size();
+        TM_LOG_DEBUG("Valid cells found: %1", validCells.size());
         
         if (validCells.isEmpty()) {
-            qDebug() << "No valid cells found!";
+            TM_LOG_DEBUG("No valid cells found!");
             return;
         }
         
@@ -422,7 +537,7 @@ void TacticalMonster::highlightValidCells(int playerIndex) {
             highlightColor = QColor(100, 100, 255, 150); // Light blue for player 2
         }
         
-        qDebug() << "Highlighting cells with color:" << highlightColor;
+        TM_LOG_DEBUG("Highlighting cells with color: %1", highlightColor.name());
         
         int highlightedCount = 0;
         for (Cell* cell : m_gamePage->getCells()) {
@@ -432,12 +547,12 @@ void TacticalMonster::highlightValidCells(int playerIndex) {
             }
         }
         
-        qDebug() << "Highlighted" << highlightedCount << "cells";
+        TM_LOG_DEBUG("Highlighted %1 cells", highlightedCount);
         
         // Store highlighted cells for later clearing (don't call startPlacement again)
         // m_gamePage->startPlacement(validCells);
     } else {
-        qDebug() << "m_gamePage is null!";
+        TM_LOG_WARNING("m_gamePage is null!");
     }
 }
 
@@ -458,12 +573,14 @@ void TacticalMonster::hideUnnecessaryUIElements() {
     // Hide the map selector and its label
     ui->MapSelector_CBox->setVisible(false);
     ui->Map_Label->setVisible(false);
+    m_lineOfSightCheck->setVisible(false);
+    m_fogOfWarCheck->setVisible(false);
     
-    qDebug() << "Hidden unnecessary UI elements for battle phase";
+    TM_LOG_DEBUG("Hidden unnecessary UI elements for battle phase");
 }
 
 void TacticalMonster::resetUIState() {
-    qDebug() << "Resetting UI state to normal";
+    TM_LOG_DEBUG("Resetting UI state to normal");
     
     // Show the player card lists (group boxes)
     ui->Player1_GroupBox->setVisible(true);
@@ -472,6 +589,8 @@ void TacticalMonster::resetUIState() {
     // Show the map selector and its label
     ui->MapSelector_CBox->setVisible(true);
     ui->Map_Label->setVisible(true);
+    m_lineOfSightCheck->setVisible(true);
+    m_fogOfWarCheck->setVisible(true);
     
     // Reset the start battle button
     ui->StartBattle_Btn->setText("Place All Agents (0/6)");
@@ -489,6 +608,14 @@ void TacticalMonster::resetUIState() {
     // Clear any cell highlights
     clearCellHighlights();
     
+    // Leave any network game
+    if (m_network) {
+        m_network->close();
+    }
+    m_localPlayer = -1;
+    m_lockstep = false;
+    ui->MapSelector_CBox->setEnabled(true);
+    
     // Reset GamePage battle state if it exists
     if (m_gamePage) {
         m_gamePage->resetBattleState();
@@ -529,6 +656,345 @@ void TacticalMonster::resetUIState() {
         }
     }
     
-    qDebug() << "UI state reset complete";
+    TM_LOG_DEBUG("UI state reset complete");
+}
+
+
+QString TacticalMonster::quickSavePath() const {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/quicksave.tmsnap";
+}
+
+void TacticalMonster::saveGame() {
+    if (!m_gamePage || ui->stackedWidget->currentWidget() != ui->PreCombat_Page) {
+        return;
+    }
+
+    QFile file(quickSavePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::warning(this, "Save Game", QString("Cannot write %1").arg(file.fileName()));
+        return;
+    }
+    file.write(m_gamePage->saveSnapshot());
+    file.close();
+    statusBar()->showMessage("Game saved", 2000);
+}
+
+void TacticalMonster::loadGame() {
+    if (!m_gamePage || ui->stackedWidget->currentWidget() != ui->PreCombat_Page || isNetworkClient()) {
+        return;
+    }
+
+    QFile file(quickSavePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Load Game", "No saved game found");
+        return;
+    }
+    const QByteArray blob = file.readAll();
+    file.close();
+
+    if (applySnapshot(blob)) {
+        sendStateToPeer();
+        statusBar()->showMessage("Game loaded", 2000);
+    }
+}
+
+bool TacticalMonster::applySnapshot(const QByteArray& blob) {
+    // Nothing on screen changes until the save is known to fit
+    QString error;
+    if (!m_gamePage->checkSnapshot(blob, &error)) {
+        QMessageBox::warning(this, "Load Game", "Saved game cannot be loaded: " + error);
+        return false;
+    }
+    GameSnapshot snapshot(blob);
+
+    const bool battle = snapshot.header().phase == GameSnapshot::Battle;
+    if (!battle && m_currentPhase == Battle) {
+        QMessageBox::warning(this, "Load Game", "Cannot load a placement-phase save during a battle");
+        return false;
+    }
+
+    // Switch the UI into battle mode first; the restore below then overrides
+    // the fresh move counters and turn that activateBattlePhase() sets up
+    if (battle && m_currentPhase != Battle) {
+        startBattlePhase();
+    }
+
+    clearCellHighlights();
+    m_currentPlacementCard = nullptr;
+    m_currentPlacementPlayer = -1;
+
+    if (!m_gamePage->restoreSnapshot(blob)) {
+        QMessageBox::warning(this, "Load Game", "Saved game does not match the available maps");
+        return false;
+    }
+
+    restorePlacedCards();
+    if (m_currentPhase != Battle) {
+        updatePlacementStatus();
+    }
+    return true;
+}
+
+void TacticalMonster::restorePlacedCards() {
+    // Cards are matched to restored agents by name, one card per agent
+    auto rebuild = [](QVBoxLayout* layout, Player* player, QList<AgentCardWidget*>& placedCards) {
+        placedCards.clear();
+        for (int i = 0; i < layout->count(); ++i) {
+            QLayoutItem* item = layout->itemAt(i);
+            AgentCardWidget* card = item ? qobject_cast<AgentCardWidget*>(item->widget()) : nullptr;
+            if (card) {
+                card->setStyleSheet("");
+            }
+        }
+        for (Agent* agent : player->getAgents()) {
+            for (int i = 0; i < layout->count(); ++i) {
+                QLayoutItem* item = layout->itemAt(i);
+                AgentCardWidget* card = item ? qobject_cast<AgentCardWidget*>(item->widget()) : nullptr;
+                if (card && card->getName() == agent->getName() && !placedCards.contains(card)) {
+                    placedCards.append(card);
+                    break;
+                }
+            }
+        }
+    };
+
+    rebuild(ui->player1CardsLayout, m_player1, m_player1PlacedCards);
+    rebuild(ui->player2CardsLayout, m_player2, m_player2PlacedCards);
 }
 
+void TacticalMonster::undoAction() {
+    if (m_gamePage && m_currentPhase == Battle && m_localPlayer < 0 && m_gamePage->undo()) {
+        statusBar()->showMessage("Action undone", 1500);
+    }
+}
+
+void TacticalMonster::redoAction() {
+    if (m_gamePage && m_currentPhase == Battle && m_localPlayer < 0 && m_gamePage->redo()) {
+        statusBar()->showMessage("Action redone", 1500);
+    }
+}
+
+void TacticalMonster::toggleTraceRecording() {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    if (!TraceRecorder::isRecording()) {
+        recorder.start();
+        statusBar()->showMessage("Recording trace... (Ctrl+T to stop)");
+        return;
+    }
+
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    const QString path = dir + "/trace-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+    if (recorder.stop(path)) {
+        statusBar()->showMessage("Trace saved to " + path, 5000);
+    } else {
+        QMessageBox::warning(this, "Trace", "Could not write " + path);
+    }
+}
+
+void TacticalMonster::setupNetworkControls() {
+    m_network = new NetworkSession(this);
+    connect(m_network, &NetworkSession::helloReceived, this, &TacticalMonster::onPeerHello);
+    connect(m_network, &NetworkSession::welcomeReceived, this, &TacticalMonster::onPeerWelcome);
+    connect(m_network, &NetworkSession::snapshotReceived, this, &TacticalMonster::onPeerSnapshot);
+    connect(m_network, &NetworkSession::actionReceived, this, &TacticalMonster::onPeerAction);
+    connect(m_network, &NetworkSession::placeReceived, this, &TacticalMonster::onPeerPlace);
+    connect(m_network, &NetworkSession::disconnected, this, &TacticalMonster::onPeerDisconnected);
+    connect(m_network, &NetworkSession::seatReceived, this, [this](int playerIndex) {
+        m_assignedSeat = playerIndex;
+    });
+    connect(m_network, &NetworkSession::deltaReceived, this, [this](const GameDelta& delta) {
+        if (m_gamePage) m_gamePage->applyRemoteDelta(delta);
+    });
+    connect(m_network, &NetworkSession::lockstepStartReceived, this, [this](quint32 seed) {
+        if (m_gamePage && isNetworkClient()) m_gamePage->startLockstep(seed);
+    });
+    connect(m_network, &NetworkSession::lockstepActionReceived, this, &TacticalMonster::onPeerLockstepAction);
+    connect(m_network, &NetworkSession::resyncRequested, this, &TacticalMonster::sendStateToPeer);
+    connect(m_network, &NetworkSession::connected, this, [this]() {
+        if (m_network->role() == NetworkSession::Client) {
+            m_network->sendHello(m_localPlayerName);
+        }
+    });
+    connect(m_network, &NetworkSession::errorOccurred, this, [this](const QString& message) {
+        statusBar()->showMessage(message, 5000);
+    });
+
+    // Host / join controls below the hot-seat "Join Game" button
+    m_addressEdit = new QLineEdit(ui->CreatServer_Page);
+    m_addressEdit->setGeometry(320, 540, 231, 31);
+    m_addressEdit->setPlaceholderText("host:port");
+    m_addressEdit->setText(QString("127.0.0.1:%1").arg(NetworkSession::DefaultPort));
+
+    m_hostOnlineBtn = new QPushButton("Host Online", ui->CreatServer_Page);
+    m_hostOnlineBtn->setGeometry(320, 585, 111, 36);
+    m_hostOnlineBtn->setCursor(Qt::PointingHandCursor);
+    connect(m_hostOnlineBtn, &QPushButton::clicked, this, &TacticalMonster::onHostOnlineClicked);
+
+    m_joinOnlineBtn = new QPushButton("Join Online", ui->CreatServer_Page);
+    m_joinOnlineBtn->setGeometry(440, 585, 111, 36);
+    m_joinOnlineBtn->setCursor(Qt::PointingHandCursor);
+    connect(m_joinOnlineBtn, &QPushButton::clicked, this, &TacticalMonster::onJoinOnlineClicked);
+
+    m_lockstepCheck = new QCheckBox("Lockstep (send actions only)", ui->CreatServer_Page);
+    m_lockstepCheck->setGeometry(320, 630, 231, 24);
+}
+
+bool TacticalMonster::isNetworkClient() const {
+    return m_network && m_network->role() == NetworkSession::Client;
+}
+
+void TacticalMonster::onHostOnlineClicked() {
+    QString address;
+    quint16 port;
+    if (ui->Player1_LineEdit->text().isEmpty()) {
+        QMessageBox::warning(this, "Warning", "Please enter Player 1's name to host!");
+        return;
+    }
+    if (!NetworkSession::parseAddress(m_addressEdit->text(), address, port)) {
+        QMessageBox::warning(this, "Warning", "Invalid port");
+        return;
+    }
+    hostGame(ui->Player1_LineEdit->text(), port, m_lockstepCheck->isChecked());
+}
+
+void TacticalMonster::onJoinOnlineClicked() {
+    QString address;
+    quint16 port;
+    if (ui->Player2_LineEdit->text().isEmpty()) {
+        QMessageBox::warning(this, "Warning", "Please enter Player 2's name to join!");
+        return;
+    }
+    if (!NetworkSession::parseAddress(m_addressEdit->text(), address, port)) {
+        QMessageBox::warning(this, "Warning", "Invalid address");
+        return;
+    }
+    joinGame(ui->Player2_LineEdit->text(), address, port);
+}
+
+void TacticalMonster::hostGame(const QString& playerName, quint16 port, bool lockstep) {
+    m_localPlayerName = playerName;
+    m_lockstep = lockstep;
+    m_lockstepCheck->setChecked(lockstep);
+    if (m_network->host(port)) {
+        statusBar()->showMessage(QString("Waiting for an opponent on port %1...").arg(port));
+    }
+}
+
+void TacticalMonster::joinGame(const QString& playerName, const QString& address, quint16 port) {
+    m_localPlayerName = playerName;
+    m_assignedSeat = 1;
+    m_network->join(address, port);
+    statusBar()->showMessage(QString("Connecting to %1:%2...").arg(address).arg(port));
+}
+
+void TacticalMonster::onPeerHello(const QString& playerName) {
+    // Host: the host is always player 1
+    m_localPlayer = 0;
+    m_network->sendWelcome(m_localPlayerName);
+    startMatch(m_localPlayerName, playerName);
+    sendStateToPeer();
+    statusBar()->showMessage(QString("%1 joined the game").arg(playerName), 3000);
+}
+
+void TacticalMonster::onPeerWelcome(const QString& playerName) {
+    // Client: the host's snapshot follows right behind this message
+    m_localPlayer = m_assignedSeat;
+    if (m_localPlayer == 0) {
+        startMatch(m_localPlayerName, playerName);
+    } else {
+        startMatch(playerName, m_localPlayerName);
+    }
+    statusBar()->showMessage(QString("Joined %1's game").arg(playerName), 3000);
+}
+
+void TacticalMonster::onPeerSnapshot(const QByteArray& blob) {
+    if (m_gamePage && isNetworkClient()) {
+        applySnapshot(blob);
+    }
+}
+
+void TacticalMonster::onPeerAction(int fromCell, int toCell) {
+    if (!m_gamePage || m_currentPhase != Battle || m_gamePage->currentPlayer() != m_player2) {
+        return;
+    }
+
+    // Rejected actions resync the client so it is never left waiting
+    if (!m_gamePage->performAction(fromCell, toCell)) {
+        sendStateToPeer();
+    }
+}
+
+void TacticalMonster::onPeerLockstepAction(int fromCell, int toCell, quint32 checksum) {
+    if (!m_gamePage || m_currentPhase != Battle || !m_gamePage->isLockstep()) {
+        return;
+    }
+
+    if (!m_gamePage->applyLockstepAction(fromCell, toCell, checksum)) {
+        // Desync: the host's state wins, sent as a fresh snapshot and seed
+        statusBar()->showMessage("Desync detected, resynchronising...", 3000);
+        if (isNetworkClient()) {
+            m_network->sendResync();
+        } else {
+            sendStateToPeer();
+        }
+    }
+}
+
+void TacticalMonster::onPeerPlace(const QString& cardName, int cellIndex) {
+    if (!m_gamePage || m_currentPhase != AgentPlacement || m_player2PlacedCards.size() >= 3) {
+        sendStateToPeer();
+        return;
+    }
+
+    const QVector<Cell*>& cells = m_gamePage->getCells();
+    Cell* cell = (cellIndex >= 0 && cellIndex < cells.size()) ? cells[cellIndex] : nullptr;
+
+    AgentCardWidget* card = nullptr;
+    for (int i = 0; i < ui->player2CardsLayout->count() && !card; ++i) {
+        QLayoutItem* item = ui->player2CardsLayout->itemAt(i);
+        AgentCardWidget* candidate = item ? qobject_cast<AgentCardWidget*>(item->widget()) : nullptr;
+        if (candidate && candidate->getName() == cardName && !m_player2PlacedCards.contains(candidate)) {
+            card = candidate;
+        }
+    }
+
+    if (card && cell && m_gamePage->getValidPlacementCells(1).contains(cell)
+        && m_gamePage->placeAgent(card, cell, 1)) {
+        m_player2PlacedCards.append(card);
+        updatePlacementStatus();
+    }
+    sendStateToPeer();
+}
+
+void TacticalMonster::onPeerDisconnected() {
+    if (m_localPlayer < 0) return;
+
+    m_network->close();
+    m_localPlayer = -1;
+    if (m_gamePage) {
+        m_gamePage->setNetworkRole(GamePage::Local, -1);
+    }
+    ui->MapSelector_CBox->setEnabled(true);
+    
+    // A dedicated server hangs up once a match is decided
+    if (m_gamePage && m_currentPhase == Battle && m_gamePage->isGameOver()) {
+        return;
+    }
+    QMessageBox::warning(this, "Network", "Your opponent disconnected. The game continues on this machine.");
+}
+
+void TacticalMonster::sendStateToPeer() {
+    if (m_gamePage && m_network && m_network->role() == NetworkSession::Host && m_network->isConnected()) {
+        m_network->sendSnapshot(m_gamePage->saveSnapshot());
+        
+        // Every battle snapshot (re)starts lockstep: fresh seed, fresh checksum chain
+        if (m_lockstep && m_currentPhase == Battle) {
+            const quint32 seed = QRandomGenerator::global()->generate();
+            m_gamePage->startLockstep(seed);
+            m_network->sendLockstepStart(seed);
+        }
+    }
+}
@@ -5,7 +5,10 @@
 #include "ui_tacticalmonster.h"
 #include "gamepage.h"
 #include "player.h"
+#include "NetworkSession.h"
+#include <QCheckBox>
 #include <QLabel>
+#include <QLineEdit>
 #include <QPushButton>
 
 class TacticalMonster : public QMainWindow {
@@ -15,6 +18,10 @@ public:
     TacticalMonster(QWidget *parent = nullptr);
     ~TacticalMonster();
 
+    // Network play (also reachable from the command line, see main.cpp)
+    void hostGame(const QString& playerName, quint16 port, bool lockstep = false);
+    void joinGame(const QString& playerName, const QString& address, quint16 port);
+
 private slots:
     // Navigation slots
     void handleNavigation();
@@ -26,6 +33,29 @@ private slots:
     void onAgentPlaced(int playerIndex);
 
     void on_OKButton_clicked();
+
+    // Quick save/load of the match in progress
+    void saveGame();
+    void loadGame();
+
+    // Undo/redo of battle actions
+    void undoAction();
+    void redoAction();
+
+    // Trace recording (see TraceRecorder.h)
+    void toggleTraceRecording();
+
+    // Network play
+    void onHostOnlineClicked();
+    void onJoinOnlineClicked();
+    void onPeerHello(const QString& playerName);
+    void onPeerWelcome(const QString& playerName);
+    void onPeerSnapshot(const QByteArray& blob);
+    void onPeerAction(int fromCell, int toCell);
+    void onPeerPlace(const QString& cardName, int cellIndex);
+    void onPeerLockstepAction(int fromCell, int toCell, quint32 checksum);
+    void onPeerDisconnected();
+    void sendStateToPeer();
     
 private:
     // Combat/Placement phase management
@@ -36,6 +66,7 @@ private:
     };
     
     void setupUI();
+    void loadPageImages(QWidget* page);
     void setupAgentSelection();
     void createAgentCards();
     void updateSelectionStatus();
@@ -48,8 +79,24 @@ private:
     void clearCellHighlights();
     void hideUnnecessaryUIElements();
     void resetUIState();
+    void restorePlacedCards();
+    QString quickSavePath() const;
+    bool applySnapshot(const QByteArray& blob);
+    void startMatch(const QString& name1, const QString& name2);
+    void setupNetworkControls();
+    bool isNetworkClient() const;
 
     Ui::TacticalMonster *ui;
+
+    // Pictures not set yet, by page (see setupUI)
+    struct PageImage {
+        QWidget* page;
+        QLabel* label;
+        QString path;
+    };
+    QVector<PageImage> m_pageImages;
+    bool m_agentCardsCreated = false;
+
     GamePage* m_gamePage = nullptr;
     Player* m_player1 = nullptr;
     Player* m_player2 = nullptr;
@@ -67,6 +114,20 @@ private:
     
     // Battle turn tracking
     QLabel* m_currentTurnLabel = nullptr;
+    QCheckBox* m_lineOfSightCheck = nullptr;
+    QCheckBox* m_fogOfWarCheck = nullptr;
+    bool m_showThreats = false;   // F6, kept across matches
+
+    // Network play
+    NetworkSession* m_network = nullptr;
+    QLineEdit* m_addressEdit = nullptr;
+    QPushButton* m_hostOnlineBtn = nullptr;
+    QPushButton* m_joinOnlineBtn = nullptr;
+    QCheckBox* m_lockstepCheck = nullptr;
+    QString m_localPlayerName;
+    int m_localPlayer = -1;   // -1 = hot seat, 0 = hosting (player 1), 1 = joined (player 2)
+    int m_assignedSeat = 1;   // Seat a dedicated server gave us; a GUI host always seats us as player 2
+    bool m_lockstep = false;  // Host only: battle runs in lockstep instead of delta sync
 };
 
 #endif // TACTICALMONSTER_H